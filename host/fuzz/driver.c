@@ -0,0 +1,164 @@
+#include <fuzz.h>
+#include <host.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <timer.h>
+
+/// @brief The longest random input
+#define FUZZ_MAX_RANDOM 64
+
+/// @brief The seed of `random` when none is given
+#define FUZZ_DEFAULT_SEED 0xF022
+
+/// @brief The characters most of the random inputs are made of, picked to
+///        form printf conversions and scratchpad commands
+static const char fuzz_alphabet[] = "%%dusxc -0123456789";
+
+/// @brief The input the harness is running with, reported when it fails
+static uint8_t fuzz_input[FUZZ_MAX_INPUT];
+static size_t fuzz_input_size;
+
+static uint32_t fuzz_random_state;
+
+/// @brief xorshift32, the driver doesn't touch the `rand` state of the
+///        code under test
+static uint32_t fuzz_random(void)
+{
+    uint32_t x = fuzz_random_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return fuzz_random_state = x;
+}
+
+static int stderr_sink(int c, void *ctx)
+{
+    (void)ctx;
+
+    char byte = (char)c;
+    return host_write(HOST_STDERR, &byte, 1) == 1 ? c : EOF;
+}
+
+/// @brief Like `printf`, but writes to stderr, stdout is the serial line
+static void fuzz_printf(const char *format, ...)
+{
+    va_list parameters;
+
+    va_start(parameters, format);
+    vcbprintf(stderr_sink, NULL, format, parameters);
+    va_end(parameters);
+}
+
+void fuzz_fail(const char *text, const char *file, int line)
+{
+    fuzz_printf("FAIL (%s:%d): %s\ninput: \"", file, line, text);
+
+    for (size_t i = 0; i < fuzz_input_size; i++)
+    {
+        uint8_t byte = fuzz_input[i];
+
+        if (byte < ' ' || byte > '~' || byte == '"' || byte == '\\')
+        {
+            fuzz_printf("\\x%c%c", "0123456789abcdef"[byte >> 4],
+                        "0123456789abcdef"[byte & 0xF]);
+        }
+        else
+        {
+            fuzz_printf("%c", byte);
+        }
+    }
+
+    fuzz_printf("\"\n");
+    host_exit(1);
+}
+
+/// @brief Harnesses without anything to prepare don't define it
+__attribute__((weak)) int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+
+    return 0;
+}
+
+/// @brief Fills `fuzz_input` with a random input, mostly from `fuzz_alphabet`
+static void fuzz_generate(void)
+{
+    fuzz_input_size = fuzz_random() % (FUZZ_MAX_RANDOM + 1);
+
+    for (size_t i = 0; i < fuzz_input_size; i++)
+    {
+        uint32_t pick = fuzz_random();
+
+        if (pick % 8 == 0)
+        {
+            fuzz_input[i] = (uint8_t)(pick >> 8);
+        }
+        else
+        {
+            fuzz_input[i] =
+                fuzz_alphabet[(pick >> 8) % (sizeof(fuzz_alphabet) - 1)];
+        }
+    }
+}
+
+/// @brief Runs the harness with the input read from stdin
+static void fuzz_stdin(void)
+{
+    while (fuzz_input_size < FUZZ_MAX_INPUT)
+    {
+        int32_t read = host_read(HOST_STDIN, fuzz_input + fuzz_input_size,
+                                 FUZZ_MAX_INPUT - fuzz_input_size);
+
+        if (read <= 0)
+        {
+            break;
+        }
+
+        fuzz_input_size += read;
+    }
+
+    LLVMFuzzerTestOneInput(fuzz_input, fuzz_input_size);
+    fuzz_printf("1 input of %u bytes passed\n", (uint32_t)fuzz_input_size);
+}
+
+/// `oslik-fuzz-<harness>` runs the harness with its stdin as the input, and
+/// `oslik-fuzz-<harness> random <runs> [seed]` with random inputs. A failing
+/// input is printed to stderr and ends the program with status 1.
+int host_main(int argc, char **argv)
+{
+    setup_timer();
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    if (argc < 3 || strcmp(argv[1], "random") != 0)
+    {
+        fuzz_stdin();
+        return 0;
+    }
+
+    uint32_t runs = (uint32_t)atoi(argv[2]);
+
+    fuzz_random_state = argc > 3 ? (uint32_t)atoi(argv[3]) : FUZZ_DEFAULT_SEED;
+
+    // xorshift never leaves zero
+    if (fuzz_random_state == 0)
+    {
+        fuzz_random_state = FUZZ_DEFAULT_SEED;
+    }
+
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        fuzz_generate();
+        LLVMFuzzerTestOneInput(fuzz_input, fuzz_input_size);
+    }
+
+    fuzz_printf("%u random inputs passed\n", runs);
+    return 0;
+}
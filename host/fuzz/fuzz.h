@@ -0,0 +1,29 @@
+/// The fuzz harnesses
+///
+/// Every harness implements libFuzzer's entry points, `LLVMFuzzerTestOneInput`
+/// and optionally `LLVMFuzzerInitialize`. The host build links the kernel's
+/// own libc, which libFuzzer can't run on, so driver.c calls them instead: with
+/// the input read from stdin, or with random inputs.
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief The longest input the driver passes to a harness
+#define FUZZ_MAX_INPUT 4096
+
+/// @brief Reports the input that broke `condition` and exits
+#define FUZZ_CHECK(condition)                                                  \
+    ((condition) ? (void)0 : fuzz_fail(#condition, __FILE__, __LINE__))
+
+__attribute__((__noreturn__)) void fuzz_fail(const char *text, const char *file,
+                                             int line);
+
+/// @brief Runs the harness with one input, returns `0`
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/// @brief Prepares the harness before the first input, returns `0`
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+
+#endif
@@ -0,0 +1,112 @@
+#include <fuzz.h>
+#include <input.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// @brief The commands, in the order they're added. Their names are made of
+///        the driver's alphabet, and some are prefixes of the others.
+static char *const names[] = {"cd", "c", "d x", "d", "%", "1 2 3"};
+
+#define COMMAND_COUNT (sizeof(names) / sizeof(names[0]))
+
+static int called;
+static const char *called_args;
+
+static void record_call(int command, const char *args)
+{
+    // one line runs at most one command
+    FUZZ_CHECK(called == -1);
+
+    called = command;
+    called_args = args;
+}
+
+#define COMMAND(index)                                                         \
+    static void command_##index(const char *args)                             \
+    {                                                                          \
+        record_call(index, args);                                              \
+    }
+
+COMMAND(0)
+COMMAND(1)
+COMMAND(2)
+COMMAND(3)
+COMMAND(4)
+COMMAND(5)
+
+static const scratchpad_cmd_callback_t callbacks[] = {
+    command_0, command_1, command_2, command_3, command_4, command_5,
+};
+
+_Static_assert(sizeof(callbacks) / sizeof(callbacks[0]) == COMMAND_COUNT,
+               "every command needs a callback");
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+
+    setup_input();
+
+    for (size_t i = 0; i < COMMAND_COUNT; i++)
+    {
+        add_command((scratchpad_cmd_t){callbacks[i], names[i],
+                                       (int)strlen(names[i])});
+    }
+
+    return 0;
+}
+
+/// The line is the input up to its first null byte. It has to run the first
+/// command whose name is followed by the end of the line or a space, with the
+/// rest of the line after the spaces, and no command when none matches.
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static char buffer[FUZZ_MAX_INPUT + 1];
+    int expected = -1;
+    const char *expected_args = NULL;
+
+    if (size > FUZZ_MAX_INPUT)
+    {
+        size = FUZZ_MAX_INPUT;
+    }
+
+    memcpy(buffer, data, size);
+    buffer[size] = '\0';
+
+    const char *line = buffer;
+
+    size_t length = strlen(line);
+
+    for (size_t i = 0; i < COMMAND_COUNT && expected == -1; i++)
+    {
+        size_t name_length = strlen(names[i]);
+
+        if (length < name_length || memcmp(line, names[i], name_length) != 0 ||
+            (line[name_length] != '\0' && line[name_length] != ' '))
+        {
+            continue;
+        }
+
+        expected = (int)i;
+        expected_args = line + name_length;
+
+        while (*expected_args == ' ')
+        {
+            expected_args++;
+        }
+    }
+
+    called = -1;
+    called_args = NULL;
+
+    // an unknown line is printed to the tty, which parses it as well
+    execute_command(line);
+
+    FUZZ_CHECK(called == expected);
+    FUZZ_CHECK(called_args == expected_args);
+
+    return 0;
+}
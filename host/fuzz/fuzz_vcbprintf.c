@@ -0,0 +1,202 @@
+#include <fuzz.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/// @brief The most conversions a format may have, the rest of it is cut off
+#define MAX_ARGS 16
+
+/// @brief Fits the formatted input, at most `FUZZ_MAX_INPUT` bytes of text and
+///        `MAX_ARGS` of the longest arguments
+#define OUTPUT_SIZE (FUZZ_MAX_INPUT + MAX_ARGS * 32)
+
+static const int32_t ints[] = {
+    0,          1,           -1,        7,          10,  -10,
+    15,         16,          255,       'A',        ' ', 1000000000,
+    -999999999, INT32_MAX,   INT32_MIN, INT32_MIN + 1,
+};
+
+static const char *const strings[] = {
+    "", "s", "text", "%d", "%", "100%%", "\x1b[31m",
+};
+
+typedef struct
+{
+    char data[OUTPUT_SIZE];
+    size_t length;
+    /// @brief The length at which the sink fails
+    size_t limit;
+} output_t;
+
+static output_t output;
+static char expected[OUTPUT_SIZE];
+static size_t expected_length;
+
+static bool is_conversion(char c)
+{
+    return c == 'c' || c == 's' || c == 'd' || c == 'u' || c == 'x';
+}
+
+static int buffer_sink(int c, void *ctx)
+{
+    output_t *out = (output_t *)ctx;
+
+    if (out->length == out->limit)
+    {
+        return EOF;
+    }
+
+    out->data[out->length++] = (char)c;
+    return c;
+}
+
+static int format(size_t limit, const char *fmt, ...)
+{
+    va_list parameters;
+
+    output.length = 0;
+    output.limit = limit;
+
+    va_start(parameters, fmt);
+    int written = vcbprintf(buffer_sink, &output, fmt, parameters);
+    va_end(parameters);
+
+    return written;
+}
+
+static void expect(const char *data, size_t length)
+{
+    memcpy(expected + expected_length, data, length);
+    expected_length += length;
+}
+
+static void expect_number(uint32_t value, uint32_t base, bool negative)
+{
+    char digits[32];
+    size_t count = 0;
+
+    if (negative)
+    {
+        expect("-", 1);
+    }
+
+    do
+    {
+        digits[count++] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value);
+
+    while (count)
+    {
+        expect(&digits[--count], 1);
+    }
+}
+
+/// The format is the input up to its first null byte, and the arguments are
+/// picked from the tables by the input's bytes. The output has to match the
+/// one of a straightforward formatter, and the returned length its length.
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static char fmt[FUZZ_MAX_INPUT + 1];
+    uintptr_t args[MAX_ARGS] = {0};
+    size_t arg_count = 0;
+
+    if (size > FUZZ_MAX_INPUT)
+    {
+        size = FUZZ_MAX_INPUT;
+    }
+
+    memcpy(fmt, data, size);
+    fmt[size] = '\0';
+    expected_length = 0;
+
+    for (char *c = fmt; *c;)
+    {
+        if (c[0] != '%')
+        {
+            expect(c++, 1);
+            continue;
+        }
+
+        if (c[1] == '%')
+        {
+            expect("%", 1);
+            c += 2;
+            continue;
+        }
+
+        if (!is_conversion(c[1]))
+        {
+            // an unknown conversion ends the formatting
+            expect(c, strlen(c));
+            break;
+        }
+
+        if (arg_count == MAX_ARGS)
+        {
+            *c = '\0';
+            break;
+        }
+
+        uint8_t pick = size ? data[(arg_count * 7) % size] : 0;
+        int32_t value = ints[pick % (sizeof(ints) / sizeof(ints[0]))];
+
+        switch (c[1])
+        {
+        case 'c':
+        {
+            char character = (char)value;
+            expect(&character, 1);
+            args[arg_count] = (uintptr_t)value;
+            break;
+        }
+        case 's':
+        {
+            const char *string =
+                strings[pick % (sizeof(strings) / sizeof(strings[0]))];
+            expect(string, strlen(string));
+            args[arg_count] = (uintptr_t)string;
+            break;
+        }
+        case 'd':
+            expect_number(value < 0 ? 0u - (uint32_t)value : (uint32_t)value,
+                          10, value < 0);
+            args[arg_count] = (uintptr_t)value;
+            break;
+        default:
+            expect_number((uint32_t)value, c[1] == 'x' ? 16 : 10, false);
+            args[arg_count] = (uintptr_t)value;
+            break;
+        }
+
+        arg_count++;
+        c += 2;
+    }
+
+#define ARGS                                                                   \
+    args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7],    \
+        args[8], args[9], args[10], args[11], args[12], args[13], args[14],    \
+        args[15]
+
+    int written = format(OUTPUT_SIZE, fmt, ARGS);
+
+    FUZZ_CHECK(written >= 0 && (size_t)written == output.length);
+    FUZZ_CHECK(output.length == expected_length);
+    FUZZ_CHECK(memcmp(output.data, expected, expected_length) == 0);
+
+    // a sink failing before the end fails the whole call
+    if (expected_length > 0)
+    {
+        size_t limit = (size ? data[size - 1] : 0) % expected_length;
+
+        FUZZ_CHECK(format(limit, fmt, ARGS) == -1);
+        FUZZ_CHECK(memcmp(output.data, expected, limit) == 0);
+    }
+
+#undef ARGS
+
+    return 0;
+}
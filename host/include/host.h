@@ -0,0 +1,34 @@
+/// The Linux side of the host build
+///
+/// The host build links the kernel's portable parts against the kernel's own
+/// libc, so it can't use the C library of the host. These are the few Linux
+/// system calls it needs, made directly.
+#ifndef HOST_H
+#define HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOST_STDIN 0
+#define HOST_STDOUT 1
+#define HOST_STDERR 2
+
+/// @returns The amount of read bytes, `0` at the end of the file, or a
+///          negative error number
+int32_t host_read(int fd, void *buffer, size_t size);
+
+/// @returns The amount of written bytes or a negative error number
+int32_t host_write(int fd, const void *buffer, size_t size);
+
+__attribute__((__noreturn__)) void host_exit(int status);
+
+/// @brief Returns the time of the monotonic clock in nanoseconds
+uint64_t host_clock_ns(void);
+
+/// @brief Writes the buffered output of the emulated serial line to stdout
+void host_serial_flush(void);
+
+/// @brief The program's entry point, called by `_start`
+int host_main(int argc, char **argv);
+
+#endif
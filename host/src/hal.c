@@ -0,0 +1,70 @@
+#include <hal.h>
+#include <host.h>
+#include <ports.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sync.h>
+#include <tty.h>
+
+/// The serial port the kernel writes to, see `serial.c`
+#define HOST_COM1 0x3f8
+#define HOST_COM1_LINE_STATUS (HOST_COM1 + 5)
+
+/// Line status: the transmitter holding register is empty
+#define LSR_THR_EMPTY 0x20
+
+#define HOST_SERIAL_BUFFER_SIZE 4096
+
+uint16_t hal_vga_memory[VGA_PAGES * VGA_PAGE_CELLS];
+uint32_t hal_eflags = EFLAGS_IF;
+
+static char serial_buffer[HOST_SERIAL_BUFFER_SIZE];
+static size_t serial_buffered;
+
+void host_serial_flush(void)
+{
+    size_t written = 0;
+
+    while (written < serial_buffered)
+    {
+        int32_t ret = host_write(HOST_STDOUT, serial_buffer + written,
+                                 serial_buffered - written);
+
+        if (ret <= 0)
+        {
+            break;
+        }
+
+        written += ret;
+    }
+
+    serial_buffered = 0;
+}
+
+/// The transmitter is always ready, and nothing is ever received - commands
+/// come from the host program's arguments and stdin instead
+uint8_t inb(uint16_t port)
+{
+    if (port == HOST_COM1_LINE_STATUS)
+    {
+        return LSR_THR_EMPTY;
+    }
+
+    return 0;
+}
+
+/// Bytes sent over COM1 go to stdout, every other port is ignored
+void outb(uint16_t port, uint8_t val)
+{
+    if (port != HOST_COM1)
+    {
+        return;
+    }
+
+    serial_buffer[serial_buffered++] = (char)val;
+
+    if (val == '\n' || serial_buffered == HOST_SERIAL_BUFFER_SIZE)
+    {
+        host_serial_flush();
+    }
+}
@@ -0,0 +1,92 @@
+#include <host.h>
+#include <input.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <timer.h>
+
+extern void init_coroutines();
+extern void init_stats();
+extern void init_bench();
+extern void init_replay();
+extern void init_tetris();
+extern void init_pong();
+
+/// @brief The longest command line read from stdin
+#define HOST_LINE_LENGTH 256
+
+/// @brief Executes the command lines read from stdin
+static void host_console(void)
+{
+    static char buffer[HOST_LINE_LENGTH];
+    char line[HOST_LINE_LENGTH + 1];
+    size_t length = 0;
+
+    while (true)
+    {
+        int32_t read = host_read(HOST_STDIN, buffer, sizeof(buffer));
+
+        if (read <= 0)
+        {
+            break;
+        }
+
+        for (int32_t i = 0; i < read; i++)
+        {
+            char c = buffer[i];
+
+            if (c == '\r' || c == '\n')
+            {
+                line[length] = '\0';
+
+                if (length > 0)
+                {
+                    execute_command(line);
+                }
+
+                length = 0;
+            }
+            else if (length < HOST_LINE_LENGTH)
+            {
+                line[length++] = c;
+            }
+        }
+    }
+
+    if (length > 0)
+    {
+        line[length] = '\0';
+        execute_command(line);
+    }
+}
+
+/// Runs the commands passed as arguments, e.g. `oslik-host "bench all"`, or
+/// the ones read from stdin when there are none. The output that the kernel
+/// writes to the serial line goes to stdout.
+int host_main(int argc, char **argv)
+{
+    setup_timer();
+    setup_input();
+
+    init_coroutines();
+    init_stats();
+    init_bench();
+    init_replay();
+    init_tetris();
+    init_pong();
+
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            execute_command(argv[i]);
+        }
+    }
+    else
+    {
+        host_console();
+    }
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+/// The kernel functions whose real implementations drive hardware that a host
+/// program doesn't have
+#include <fpu.h>
+#include <host.h>
+#include <input.h>
+#include <keyboard.h>
+#include <panic.h>
+#include <qemu.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// There is no keyboard, so no key is ever held
+bool key_is_held(keys_t key)
+{
+    (void)key;
+
+    return false;
+}
+
+/// Injected scancodes have no keyboard interrupt to pick them up
+void keyboard_inject(uint8_t scancode)
+{
+    (void)scancode;
+}
+
+/// The host program's FPU state is saved by Linux
+void fpu_switch(fpu_context_t **context)
+{
+    (void)context;
+}
+
+void fpu_release(fpu_context_t **context)
+{
+    *context = NULL;
+}
+
+void start_kpanic()
+{
+    printf("-------- KERNEL PANIC --------\n\n");
+}
+
+void end_kpanic()
+{
+    printf("\n------------------------------\n");
+
+    // the same exit code that QEMU reports for a kernel panic
+    host_exit((QEMU_EXIT_PANIC << 1) | 1);
+}
+
+void kpanic(const char *__restrict format, ...)
+{
+    start_kpanic();
+
+    va_list args;
+    va_start(args, format);
+
+    vprintf(format, args);
+
+    va_end(args);
+
+    end_kpanic();
+}
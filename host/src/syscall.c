@@ -0,0 +1,78 @@
+#include <host.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// i386 Linux system call numbers
+#define SYS_EXIT 1
+#define SYS_READ 3
+#define SYS_WRITE 4
+#define SYS_CLOCK_GETTIME 265
+
+#define CLOCK_MONOTONIC 1
+
+typedef struct
+{
+    int32_t tv_sec;
+    int32_t tv_nsec;
+} host_timespec_t;
+
+static inline int32_t host_syscall3(uint32_t number, uint32_t arg1,
+                                    uint32_t arg2, uint32_t arg3)
+{
+    int32_t ret;
+
+    __asm__ volatile("int $0x80"
+                     : "=a"(ret)
+                     : "a"(number), "b"(arg1), "c"(arg2), "d"(arg3)
+                     : "memory");
+
+    return ret;
+}
+
+int32_t host_read(int fd, void *buffer, size_t size)
+{
+    return host_syscall3(SYS_READ, fd, (uint32_t)buffer, size);
+}
+
+int32_t host_write(int fd, const void *buffer, size_t size)
+{
+    return host_syscall3(SYS_WRITE, fd, (uint32_t)buffer, size);
+}
+
+uint64_t host_clock_ns(void)
+{
+    host_timespec_t time;
+
+    host_syscall3(SYS_CLOCK_GETTIME, CLOCK_MONOTONIC, (uint32_t)&time, 0);
+
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+void host_exit(int status)
+{
+    host_serial_flush();
+    host_syscall3(SYS_EXIT, status, 0, 0);
+    __builtin_unreachable();
+}
+
+/// @brief Called by `_start` with the initial stack pointer, which points at
+///        `argc`, followed by the `argv` array
+__attribute__((used)) static void host_start(uint32_t *stack)
+{
+    int argc = (int)stack[0];
+    char **argv = (char **)&stack[1];
+
+    host_exit(host_main(argc, argv));
+}
+
+// A zero frame pointer ends stack walks, and the stack is aligned for SSE
+__asm__(".text\n"
+        ".global _start\n"
+        "_start:\n"
+        "    xor %ebp, %ebp\n"
+        "    mov %esp, %eax\n"
+        "    and $-16, %esp\n"
+        "    sub $12, %esp\n"
+        "    push %eax\n"
+        "    call host_start\n"
+        "    hlt\n");
@@ -0,0 +1,47 @@
+/// The timer, driven by the host's monotonic clock instead of the PIT
+#include <host.h>
+#include <random.h>
+#include <stdint.h>
+#include <timer.h>
+
+/// The nanoseconds the TSC is calibrated over
+#define TSC_CALIBRATION_NS 10000000
+
+static uint64_t start_ns;
+static uint32_t tsc_khz;
+
+void setup_timer(void)
+{
+    start_ns = host_clock_ns();
+}
+
+void timer_tick(void)
+{
+}
+
+uint64_t timer_ticks(void)
+{
+    return (host_clock_ns() - start_ns) * TIMER_HZ / 1000000000;
+}
+
+uint32_t timer_tsc_khz(void)
+{
+    if (tsc_khz != 0)
+    {
+        return tsc_khz;
+    }
+
+    uint64_t start = host_clock_ns();
+    uint64_t start_tsc = rdtsc();
+
+    while (host_clock_ns() - start < TSC_CALIBRATION_NS)
+    {
+    }
+
+    uint64_t cycles = rdtsc() - start_tsc;
+    uint64_t elapsed_ns = host_clock_ns() - start;
+
+    tsc_khz = (uint32_t)(cycles * 1000000 / elapsed_ns);
+
+    return tsc_khz;
+}
@@ -0,0 +1,90 @@
+#include <input.h>
+#include <serial.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <test.h>
+#include <timer.h>
+
+/// @brief The failed checks so far
+static uint32_t test_failures;
+static uint32_t tests_run;
+static uint32_t tests_failed;
+
+static const char *test_name;
+
+/// The results go straight to the serial line, i.e. stdout, so they don't
+/// depend on the tty code that some of the tests exercise
+static void test_fail(const char *file, int line)
+{
+    serial_printf("FAIL %s (%s:%d): ", test_name, file, line);
+    test_failures++;
+}
+
+void test_check(bool condition, const char *text, const char *file, int line)
+{
+    if (!condition)
+    {
+        test_fail(file, line);
+        serial_printf("%s\n", text);
+    }
+}
+
+void test_check_eq(uint32_t actual, uint32_t expected, const char *text,
+                   const char *file, int line)
+{
+    if (actual != expected)
+    {
+        test_fail(file, line);
+        serial_printf("%s is %u (0x%x), expected %u (0x%x)\n", text, actual,
+                      actual, expected, expected);
+    }
+}
+
+void test_check_str(const char *actual, const char *expected,
+                    const char *text, const char *file, int line)
+{
+    if (strcmp(actual, expected) != 0)
+    {
+        test_fail(file, line);
+        serial_printf("%s is \"%s\", expected \"%s\"\n", text, actual,
+                      expected);
+    }
+}
+
+void test_run(const char *name, void (*test)(void))
+{
+    uint32_t failures_before = test_failures;
+
+    test_name = name;
+
+    test();
+
+    tests_run++;
+
+    if (test_failures != failures_before)
+    {
+        tests_failed++;
+    }
+}
+
+/// Runs every suite, and fails `make test` when any of the tests failed
+int host_main(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    setup_timer();
+    setup_input();
+
+    test_tty_suite();
+    test_scratchpad_suite();
+    test_printf_suite();
+    test_tetris_suite();
+    test_pong_suite();
+    test_fixed_suite();
+
+    serial_printf("%u tests, %u failed\n", tests_run, tests_failed);
+
+    return tests_failed ? 1 : 0;
+}
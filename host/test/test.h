@@ -0,0 +1,46 @@
+/// Assertions for the host tests
+///
+/// A test is a function that checks its expectations with the `TEST_CHECK`
+/// macros, which report every failed check and carry on with the test. Each
+/// test file has a suite function running its tests with `TEST_RUN`, which
+/// `host_main` in main.c calls.
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief Checks that `condition` holds
+#define TEST_CHECK(condition)                                                  \
+    test_check((condition), #condition, __FILE__, __LINE__)
+
+/// @brief Checks that two integers are equal, printing both when they aren't
+#define TEST_CHECK_EQ(actual, expected)                                        \
+    test_check_eq((uint32_t)(actual), (uint32_t)(expected), #actual,         \
+                  __FILE__, __LINE__)
+
+/// @brief Checks that two null-terminated strings are equal
+#define TEST_CHECK_STR(actual, expected)                                       \
+    test_check_str((actual), (expected), #actual, __FILE__, __LINE__)
+
+/// @brief Runs the test function `test`, reporting it under its name
+#define TEST_RUN(test) test_run(#test, test)
+
+void test_check(bool condition, const char *text, const char *file, int line);
+
+void test_check_eq(uint32_t actual, uint32_t expected, const char *text,
+                   const char *file, int line);
+
+void test_check_str(const char *actual, const char *expected,
+                    const char *text, const char *file, int line);
+
+void test_run(const char *name, void (*test)(void));
+
+void test_tty_suite(void);
+void test_scratchpad_suite(void);
+void test_printf_suite(void);
+void test_tetris_suite(void);
+void test_pong_suite(void);
+void test_fixed_suite(void);
+
+#endif
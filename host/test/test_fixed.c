@@ -0,0 +1,111 @@
+#include <fixed.h>
+#include <stdint.h>
+#include <test.h>
+
+static void test_conversions(void)
+{
+    TEST_CHECK_EQ(fixed_from_int(3), FIXED_INT(3));
+    TEST_CHECK_EQ(fixed_from_int(-3), FIXED_INT(-3));
+    TEST_CHECK_EQ(fixed_from_int(40000), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_from_int(-40000), FIXED_MIN);
+
+    // rounds towards negative infinity
+    TEST_CHECK_EQ(fixed_to_int(FIXED_RATIO(3, 2)), 1);
+    TEST_CHECK_EQ(fixed_to_int(FIXED_RATIO(-1, 2)), -1);
+}
+
+static void test_add_sub(void)
+{
+    TEST_CHECK_EQ(fixed_add_sat(FIXED_INT(2), FIXED_RATIO(1, 2)),
+                  FIXED_RATIO(5, 2));
+    TEST_CHECK_EQ(fixed_add_sat(FIXED_MAX, 1), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_add_sat(FIXED_MAX, FIXED_MAX), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_add_sat(FIXED_MIN, -1), FIXED_MIN);
+    TEST_CHECK_EQ(fixed_add_sat(FIXED_MIN, FIXED_MIN), FIXED_MIN);
+    TEST_CHECK_EQ(fixed_add_sat(FIXED_MAX, FIXED_MIN), -1);
+
+    TEST_CHECK_EQ(fixed_sub_sat(FIXED_INT(1), FIXED_INT(3)), FIXED_INT(-2));
+    TEST_CHECK_EQ(fixed_sub_sat(FIXED_MIN, 1), FIXED_MIN);
+    TEST_CHECK_EQ(fixed_sub_sat(FIXED_MAX, -1), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_sub_sat(0, FIXED_MIN), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_sub_sat(-1, FIXED_MIN), FIXED_MAX);
+}
+
+static void test_mul(void)
+{
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_INT(3), FIXED_RATIO(1, 2)),
+                  FIXED_RATIO(3, 2));
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_INT(-4), FIXED_INT(5)), FIXED_INT(-20));
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_MAX, FIXED_ONE), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_MIN, FIXED_ONE), FIXED_MIN);
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_MAX, FIXED_INT(2)), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_MIN, FIXED_INT(2)), FIXED_MIN);
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_MAX, -FIXED_ONE), -FIXED_MAX);
+
+    // -FIXED_MIN doesn't fit
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_MIN, -FIXED_ONE), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_mul_sat(FIXED_MIN, FIXED_MIN), FIXED_MAX);
+
+    // rounds towards negative infinity
+    TEST_CHECK_EQ(fixed_mul_sat(1, FIXED_RATIO(1, 2)), 0);
+    TEST_CHECK_EQ(fixed_mul_sat(-1, FIXED_RATIO(1, 2)), -1);
+}
+
+static void test_clamp(void)
+{
+    TEST_CHECK_EQ(fixed_clamp(FIXED_INT(5), FIXED_INT(1), FIXED_INT(9)),
+                  FIXED_INT(5));
+    TEST_CHECK_EQ(fixed_clamp(FIXED_INT(-5), FIXED_INT(1), FIXED_INT(9)),
+                  FIXED_INT(1));
+    TEST_CHECK_EQ(fixed_clamp(FIXED_MAX, FIXED_INT(1), FIXED_INT(9)),
+                  FIXED_INT(9));
+    TEST_CHECK_EQ(fixed_clamp(FIXED_MIN, FIXED_MIN, FIXED_MAX), FIXED_MIN);
+    TEST_CHECK_EQ(fixed_clamp(FIXED_INT(5), FIXED_INT(2), FIXED_INT(2)),
+                  FIXED_INT(2));
+}
+
+static void test_lerp(void)
+{
+    TEST_CHECK_EQ(fixed_lerp(FIXED_INT(2), FIXED_INT(10), 0), FIXED_INT(2));
+    TEST_CHECK_EQ(fixed_lerp(FIXED_INT(2), FIXED_INT(10), FIXED_ONE),
+                  FIXED_INT(10));
+    TEST_CHECK_EQ(fixed_lerp(FIXED_INT(2), FIXED_INT(10), FIXED_RATIO(1, 4)),
+                  FIXED_INT(4));
+    TEST_CHECK_EQ(fixed_lerp(FIXED_INT(10), FIXED_INT(2), FIXED_RATIO(1, 2)),
+                  FIXED_INT(6));
+
+    // the distance between the extremes doesn't fit into a fixed_t
+    TEST_CHECK_EQ(fixed_lerp(FIXED_MIN, FIXED_MAX, 0), FIXED_MIN);
+    TEST_CHECK_EQ(fixed_lerp(FIXED_MIN, FIXED_MAX, FIXED_ONE), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_lerp(FIXED_MAX, FIXED_MIN, 0), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_lerp(FIXED_MAX, FIXED_MIN, FIXED_ONE), FIXED_MIN);
+
+    // extrapolating saturates
+    TEST_CHECK_EQ(fixed_lerp(0, FIXED_MAX, FIXED_INT(2)), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_lerp(0, FIXED_MIN, FIXED_INT(2)), FIXED_MIN);
+}
+
+static void test_ratio(void)
+{
+    TEST_CHECK_EQ(fixed_ratio(0, 5), 0);
+    TEST_CHECK_EQ(fixed_ratio(1, 2), FIXED_RATIO(1, 2));
+    TEST_CHECK_EQ(fixed_ratio(7, 3), FIXED_RATIO(7, 3));
+    TEST_CHECK_EQ(fixed_ratio(1ull << 47, 1ull << 48), FIXED_RATIO(1, 2));
+    TEST_CHECK_EQ(fixed_ratio(32767, 1), FIXED_INT(32767));
+    TEST_CHECK_EQ(fixed_ratio(65535, 2), FIXED_RATIO(65535, 2));
+
+    // the whole part doesn't fit
+    TEST_CHECK_EQ(fixed_ratio(32768, 1), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_ratio(UINT64_MAX, 1), FIXED_MAX);
+    TEST_CHECK_EQ(fixed_ratio(UINT64_MAX, 3), FIXED_MAX);
+}
+
+void test_fixed_suite(void)
+{
+    TEST_RUN(test_conversions);
+    TEST_RUN(test_add_sub);
+    TEST_RUN(test_mul);
+    TEST_RUN(test_clamp);
+    TEST_RUN(test_lerp);
+    TEST_RUN(test_ratio);
+}
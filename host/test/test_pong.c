@@ -0,0 +1,53 @@
+// The tests reach into the game's static functions, so pong.c is built as a
+// part of this file instead of on its own
+#include "../../kernel/src/pong.c"
+
+#include <test.h>
+
+static void test_trajectory(void)
+{
+    TEST_CHECK_EQ(pong_sim_run(PONG_CHECK_UPDATES), PONG_CHECK_TRAJECTORY);
+}
+
+static void test_determinism(void)
+{
+    uint32_t first = pong_sim_run(1000);
+
+    TEST_CHECK_EQ(pong_sim_run(1000), first);
+    TEST_CHECK(pong_sim_run(1001) != first);
+}
+
+static void test_bounds(void)
+{
+    pong_sim_reset();
+
+    for (uint32_t i = 0; i < PONG_CHECK_UPDATES; i++)
+    {
+        pong_sim_update(&pong_sim_game);
+
+        ivec2_t ball = quantize_from_fvec2(pong_sim_game.ball.position);
+        int left = pong_sim_game.left_paddle.verticalPosition;
+        int right = pong_sim_game.right_paddle.verticalPosition;
+
+        bool ball_inside = ball.x >= FRAME_START_X && ball.x <= FRAME_END_X &&
+                           ball.y >= FRAME_START_Y && ball.y <= FRAME_END_Y;
+        bool paddles_inside =
+            left >= FRAME_START_Y && left + PADDLE_HEIGHT <= FRAME_SIZE_Y &&
+            right >= FRAME_START_Y && right + PADDLE_HEIGHT <= FRAME_SIZE_Y;
+
+        // a broken game would fail every update after this one
+        if (!ball_inside || !paddles_inside)
+        {
+            TEST_CHECK(ball_inside);
+            TEST_CHECK(paddles_inside);
+            break;
+        }
+    }
+}
+
+void test_pong_suite(void)
+{
+    TEST_RUN(test_trajectory);
+    TEST_RUN(test_determinism);
+    TEST_RUN(test_bounds);
+}
@@ -0,0 +1,127 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <test.h>
+
+/// @brief The longest output a test formats
+#define OUTPUT_LENGTH 128
+
+typedef struct
+{
+    char data[OUTPUT_LENGTH];
+    size_t length;
+} output_t;
+
+static int buffer_sink(int c, void *ctx)
+{
+    output_t *output = (output_t *)ctx;
+
+    if (output->length == OUTPUT_LENGTH - 1)
+    {
+        return EOF;
+    }
+
+    output->data[output->length++] = (char)c;
+    return c;
+}
+
+static output_t output;
+
+/// @brief Formats into `output`
+/// @returns What `vcbprintf` returned
+static int format_written(const char *fmt, ...)
+{
+    va_list parameters;
+
+    memset(&output, 0, sizeof(output));
+
+    va_start(parameters, fmt);
+    int written = vcbprintf(buffer_sink, &output, fmt, parameters);
+    va_end(parameters);
+
+    return written;
+}
+
+static const char *formatted(int written, const char *file, int line)
+{
+    test_check_eq(written, output.length, "written", file, line);
+
+    return output.data;
+}
+
+/// @brief Formats into `output`, checking that the returned length matches
+///        the sunk characters
+#define format(...)                                                            \
+    formatted(format_written(__VA_ARGS__), __FILE__, __LINE__)
+
+static void test_plain(void)
+{
+    TEST_CHECK_STR(format(""), "");
+    TEST_CHECK_STR(format("no conversions"), "no conversions");
+    TEST_CHECK_STR(format("100%%"), "100%");
+    TEST_CHECK_STR(format("%%%%d"), "%%d");
+}
+
+static void test_signed(void)
+{
+    TEST_CHECK_STR(format("%d", 0), "0");
+    TEST_CHECK_STR(format("%d", 42), "42");
+    TEST_CHECK_STR(format("%d", -7), "-7");
+    TEST_CHECK_STR(format("%d", INT32_MAX), "2147483647");
+    TEST_CHECK_STR(format("%d", INT32_MIN), "-2147483648");
+}
+
+static void test_unsigned(void)
+{
+    TEST_CHECK_STR(format("%u", 0u), "0");
+    TEST_CHECK_STR(format("%u", 1234567u), "1234567");
+    TEST_CHECK_STR(format("%u", UINT32_MAX), "4294967295");
+    TEST_CHECK_STR(format("%u", -1), "4294967295");
+}
+
+static void test_hex(void)
+{
+    TEST_CHECK_STR(format("%x", 0u), "0");
+    TEST_CHECK_STR(format("%x", 0xBEEFu), "beef");
+    TEST_CHECK_STR(format("0x%x", UINT32_MAX), "0xffffffff");
+    TEST_CHECK_STR(format("%x", INT32_MIN), "80000000");
+}
+
+static void test_strings_and_chars(void)
+{
+    TEST_CHECK_STR(format("%s", ""), "");
+    TEST_CHECK_STR(format("[%s]", "text"), "[text]");
+    TEST_CHECK_STR(format("%c%c%c", 'a', 'b', 'c'), "abc");
+    TEST_CHECK_STR(format("%s=%d%c", "x", -3, '!'), "x=-3!");
+}
+
+static void test_unknown_conversions(void)
+{
+    // the rest of the format is written as it is
+    TEST_CHECK_STR(format("%d %q %d", 1, 2), "1 %q %d");
+    TEST_CHECK_STR(format("end %"), "end %");
+}
+
+static void test_sink_failure(void)
+{
+    char text[OUTPUT_LENGTH + 1];
+
+    memset(text, 'x', OUTPUT_LENGTH);
+    text[OUTPUT_LENGTH] = '\0';
+
+    // the sink takes one character less than the text
+    TEST_CHECK_EQ(format_written("%s", text), -1);
+    TEST_CHECK_EQ(format_written(text), -1);
+}
+
+void test_printf_suite(void)
+{
+    TEST_RUN(test_plain);
+    TEST_RUN(test_signed);
+    TEST_RUN(test_unsigned);
+    TEST_RUN(test_hex);
+    TEST_RUN(test_strings_and_chars);
+    TEST_RUN(test_unknown_conversions);
+    TEST_RUN(test_sink_failure);
+}
@@ -0,0 +1,93 @@
+#include <input.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <test.h>
+
+/// @brief The longest arguments a test command records
+#define ARGS_LENGTH 64
+
+/// @brief What the last of the test commands was called with
+static struct
+{
+    int command;
+    uint32_t calls;
+    char args[ARGS_LENGTH];
+} last_call;
+
+static void record_call(int command, const char *args)
+{
+    size_t length = strlen(args);
+
+    last_call.command = command;
+    last_call.calls++;
+    memcpy(last_call.args, args,
+           length < ARGS_LENGTH - 1 ? length : ARGS_LENGTH - 1);
+}
+
+static void tetris_callback(const char *args)
+{
+    record_call(1, args);
+}
+
+static void tetrisx_callback(const char *args)
+{
+    record_call(2, args);
+}
+
+static void tet_callback(const char *args)
+{
+    record_call(3, args);
+}
+
+/// @brief Executes `line`, returning the test command it called or `0`
+static int execute(const char *line)
+{
+    uint32_t calls = last_call.calls;
+
+    memset(&last_call.args, 0, sizeof(last_call.args));
+    execute_command(line);
+
+    return last_call.calls == calls ? 0 : last_call.command;
+}
+
+static void test_names(void)
+{
+    TEST_CHECK_EQ(execute("tetris"), 1);
+    TEST_CHECK_EQ(execute("tetrisx"), 2);
+    TEST_CHECK_EQ(execute("tet"), 3);
+
+    // a name has to be followed by the end of the line or a space
+    TEST_CHECK_EQ(execute("tetrisxy"), 0);
+    TEST_CHECK_EQ(execute("te"), 0);
+    TEST_CHECK_EQ(execute(""), 0);
+    TEST_CHECK_EQ(execute(" tetris"), 0);
+    TEST_CHECK_EQ(execute("TETRIS"), 0);
+}
+
+static void test_arguments(void)
+{
+    TEST_CHECK_EQ(execute("tetris"), 1);
+    TEST_CHECK_STR(last_call.args, "");
+
+    TEST_CHECK_EQ(execute("tetris sim 10"), 1);
+    TEST_CHECK_STR(last_call.args, "sim 10");
+
+    // only the leading spaces are stripped
+    TEST_CHECK_EQ(execute("tetrisx    a  b "), 2);
+    TEST_CHECK_STR(last_call.args, "a  b ");
+
+    TEST_CHECK_EQ(execute("tet "), 3);
+    TEST_CHECK_STR(last_call.args, "");
+}
+
+void test_scratchpad_suite(void)
+{
+    // `tet` goes last, so that it doesn't shadow the longer names
+    add_command((scratchpad_cmd_t){tetris_callback, "tetris", 6});
+    add_command((scratchpad_cmd_t){tetrisx_callback, "tetrisx", 7});
+    add_command((scratchpad_cmd_t){tet_callback, "tet", 3});
+
+    TEST_RUN(test_names);
+    TEST_RUN(test_arguments);
+}
@@ -0,0 +1,193 @@
+// The tests reach into the game's static functions, so tetris.c is built as a
+// part of this file instead of on its own
+#include "../../kernel/src/tetris.c"
+
+#include <test.h>
+
+/// @brief The T shape, see `shapes`
+#define SHAPE_T 0
+
+/// @brief A row with a block in column `x`
+#define ROW_WITH(x) ((uint16_t)(TETRIS_ROW_EMPTY | (1u << ((x) + TETRIS_WALL))))
+
+static board_t board;
+
+static bool collides(uint32_t shape, uint32_t angle, int32_t x, int32_t y)
+{
+    piece_t piece = {shape, {x, y}, TTY_COLOR_RED, angle};
+
+    return does_piece_colilde(&board, &piece);
+}
+
+static void test_piece_masks(void)
+{
+    for (uint32_t shape = 0; shape < SHAPE_COUNT; shape++)
+    {
+        for (uint32_t angle = 0; angle < 4; angle++)
+        {
+            const piece_mask_t *mask = &piece_masks[shape][angle];
+            uint32_t bits = 0;
+
+            for (int i = 0; i < PIECE_BOX; i++)
+            {
+                bits += count_bits(mask->rows[i]);
+            }
+
+            TEST_CHECK_EQ(bits, 4);
+
+            // every block is in the box, where the mask has its bit
+            for (int i = 0; i < 4; i++)
+            {
+                vec2_t block = add_vec2(mask->blocks[i],
+                                        negate_vec2(mask->corner));
+
+                TEST_CHECK(block.x >= 0 && block.x < PIECE_BOX);
+                TEST_CHECK(block.y >= 0 && block.y < PIECE_BOX);
+                TEST_CHECK((mask->rows[block.y] >> block.x) & 1);
+            }
+        }
+    }
+}
+
+static void test_collision_with_walls(void)
+{
+    reset_board(&board);
+
+    // the T is 3 blocks wide, around its position
+    TEST_CHECK(!collides(SHAPE_T, 0, 5, 1));
+    TEST_CHECK(!collides(SHAPE_T, 0, 1, 1));
+    TEST_CHECK(!collides(SHAPE_T, 0, TETRIS_WIDTH - 2, 1));
+    TEST_CHECK(collides(SHAPE_T, 0, 0, 1));
+    TEST_CHECK(collides(SHAPE_T, 0, TETRIS_WIDTH - 1, 1));
+
+    // far behind the walls, where the box doesn't fit into a row
+    TEST_CHECK(collides(SHAPE_T, 0, -10, 1));
+    TEST_CHECK(collides(SHAPE_T, 0, TETRIS_WIDTH + 10, 1));
+}
+
+static void test_collision_with_floor_and_ceiling(void)
+{
+    reset_board(&board);
+
+    // the T's stem is below its position
+    TEST_CHECK(!collides(SHAPE_T, 0, 5, 0));
+    TEST_CHECK(!collides(SHAPE_T, 0, 5, TETRIS_HEIGHT - 2));
+    TEST_CHECK(collides(SHAPE_T, 0, 5, -1));
+    TEST_CHECK(collides(SHAPE_T, 0, 5, TETRIS_HEIGHT - 1));
+    TEST_CHECK(collides(SHAPE_T, 0, 5, TETRIS_HEIGHT + 10));
+}
+
+static void test_collision_with_blocks(void)
+{
+    reset_board(&board);
+    board.rows[10] = ROW_WITH(5);
+
+    TEST_CHECK(collides(SHAPE_T, 0, 5, 9));
+    TEST_CHECK(collides(SHAPE_T, 0, 6, 10));
+    TEST_CHECK(!collides(SHAPE_T, 0, 5, 8));
+    TEST_CHECK(!collides(SHAPE_T, 0, 7, 10));
+
+    board.falling_piece = (piece_t){SHAPE_T, {5, 7}, TTY_COLOR_RED, 0};
+
+    TEST_CHECK(!does_falling_piece_collide_after_moving(&board, (vec2_t){0, 1}));
+    TEST_CHECK(does_falling_piece_collide_after_moving(&board, (vec2_t){0, 2}));
+
+    // moving only checks, the piece stays where it was
+    TEST_CHECK_EQ(board.falling_piece.position.x, 5);
+    TEST_CHECK_EQ(board.falling_piece.position.y, 7);
+}
+
+static void test_compact_rows(void)
+{
+    uint16_t rows[TETRIS_HEIGHT];
+
+    for (int y = 0; y < TETRIS_HEIGHT; y++)
+    {
+        rows[y] = TETRIS_ROW_EMPTY;
+    }
+
+    TEST_CHECK_EQ(compact_rows(rows, NULL), 0);
+
+    rows[19] = TETRIS_ROW_FULL;
+    rows[18] = ROW_WITH(0);
+    rows[17] = TETRIS_ROW_FULL;
+    rows[16] = ROW_WITH(9);
+    rows[15] = ROW_WITH(4);
+
+    TEST_CHECK_EQ(compact_rows(rows, NULL), 2);
+    TEST_CHECK_EQ(rows[19], ROW_WITH(0));
+    TEST_CHECK_EQ(rows[18], ROW_WITH(9));
+    TEST_CHECK_EQ(rows[17], ROW_WITH(4));
+
+    for (int y = 0; y < 17; y++)
+    {
+        TEST_CHECK_EQ(rows[y], TETRIS_ROW_EMPTY);
+    }
+
+    for (int y = 0; y < TETRIS_HEIGHT; y++)
+    {
+        rows[y] = TETRIS_ROW_FULL;
+    }
+
+    TEST_CHECK_EQ(compact_rows(rows, NULL), TETRIS_HEIGHT);
+    TEST_CHECK_EQ(rows[0], TETRIS_ROW_EMPTY);
+    TEST_CHECK_EQ(rows[TETRIS_HEIGHT - 1], TETRIS_ROW_EMPTY);
+}
+
+static void test_compact_rows_with_colors(void)
+{
+    reset_board(&board);
+
+    board.rows[19] = ROW_WITH(2);
+    board.colors[19][2] = TTY_COLOR_BLUE;
+    board.rows[18] = TETRIS_ROW_FULL;
+    memset(board.colors[18], TTY_COLOR_GREEN, TETRIS_WIDTH);
+    board.rows[0] = ROW_WITH(7);
+    board.colors[0][7] = TTY_COLOR_RED;
+
+    TEST_CHECK_EQ(check_board_for_clearing(&board), 1);
+    TEST_CHECK_EQ(board.rows[19], ROW_WITH(2));
+    TEST_CHECK_EQ(board.colors[19][2], TTY_COLOR_BLUE);
+    TEST_CHECK_EQ(board.rows[1], ROW_WITH(7));
+    TEST_CHECK_EQ(board.colors[1][7], TTY_COLOR_RED);
+    TEST_CHECK_EQ(board.rows[0], TETRIS_ROW_EMPTY);
+    TEST_CHECK_EQ(board.colors[0][7], 0);
+
+    for (int x = 0; x < TETRIS_WIDTH; x++)
+    {
+        TEST_CHECK(board.colors[18][x] != TTY_COLOR_GREEN);
+    }
+}
+
+static void test_clearing_a_placed_piece(void)
+{
+    reset_board(&board);
+
+    // the bottom row misses the block under the T's stem
+    board.rows[19] = TETRIS_ROW_FULL & ~(1u << (5 + TETRIS_WALL));
+    board.falling_piece = (piece_t){SHAPE_T, {5, 18}, TTY_COLOR_CYAN, 0};
+
+    TEST_CHECK(!does_piece_colilde(&board, &board.falling_piece));
+
+    solidify_falling_piece(&board);
+
+    TEST_CHECK_EQ(check_board_for_clearing(&board), 1);
+    TEST_CHECK_EQ(board.rows[19],
+                  ROW_WITH(4) | ROW_WITH(5) | ROW_WITH(6));
+    TEST_CHECK_EQ(board.colors[19][4], TTY_COLOR_CYAN);
+    TEST_CHECK_EQ(board.colors[19][6], TTY_COLOR_CYAN);
+    TEST_CHECK_EQ(board.rows[18], TETRIS_ROW_EMPTY);
+}
+
+void test_tetris_suite(void)
+{
+    build_piece_masks();
+
+    TEST_RUN(test_piece_masks);
+    TEST_RUN(test_collision_with_walls);
+    TEST_RUN(test_collision_with_floor_and_ceiling);
+    TEST_RUN(test_collision_with_blocks);
+    TEST_RUN(test_compact_rows);
+    TEST_RUN(test_compact_rows_with_colors);
+    TEST_RUN(test_clearing_a_placed_piece);
+}
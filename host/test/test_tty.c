@@ -0,0 +1,283 @@
+#include <stdint.h>
+#include <string.h>
+#include <test.h>
+#include <tty.h>
+
+/// @brief White on black, the color of a cleared tty
+#define DEFAULT_ATTRIBUTE 0x0F00
+
+static tty_t tty;
+
+static void write(const char *data)
+{
+    tty_write(&tty, data, strlen(data));
+}
+
+static uint16_t cell_at(size_t x, size_t y)
+{
+    return tty.buffer[y * VGA_WIDTH + x];
+}
+
+static char char_at(size_t x, size_t y)
+{
+    return (char)(cell_at(x, y) & 0xFF);
+}
+
+/// @brief Checks that the cells of row `y` start with `text` and are blank
+///        after it
+static void check_row(size_t y, const char *text, const char *file, int line)
+{
+    size_t length = strlen(text);
+
+    for (size_t x = 0; x < VGA_WIDTH; x++)
+    {
+        char expected = x < length ? text[x] : ' ';
+
+        if (char_at(x, y) != expected)
+        {
+            test_check_eq(char_at(x, y), expected, "row character", file,
+                          line);
+            return;
+        }
+    }
+}
+
+#define CHECK_ROW(y, text) check_row((y), (text), __FILE__, __LINE__)
+
+#define CHECK_CURSOR(row, col)                                                 \
+    do                                                                         \
+    {                                                                          \
+        TEST_CHECK_EQ(tty.cursor_row, (row));                                  \
+        TEST_CHECK_EQ(tty.cursor_col, (col));                                  \
+    } while (0)
+
+static void reset(void)
+{
+    tty_initialize_shadow(&tty);
+}
+
+static void test_plain_text(void)
+{
+    reset();
+    write("abc");
+
+    CHECK_ROW(0, "abc");
+    TEST_CHECK_EQ(cell_at(0, 0), DEFAULT_ATTRIBUTE | 'a');
+    CHECK_CURSOR(0, 3);
+
+    write("\nde\rX");
+
+    CHECK_ROW(1, "Xe");
+    CHECK_CURSOR(1, 1);
+}
+
+static void test_wrapping(void)
+{
+    char line[VGA_WIDTH + 6];
+
+    reset();
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    write(line);
+
+    TEST_CHECK_EQ(char_at(VGA_WIDTH - 1, 0), 'x');
+    CHECK_ROW(1, "xxxxx");
+    CHECK_CURSOR(1, 5);
+}
+
+static void test_scrolling(void)
+{
+    reset();
+
+    // the scratchpad's row below the tty never scrolls
+    tty_set_char_at(&tty, '>', 0, TTY_HEIGHT);
+
+    for (char c = 'A'; c < 'A' + TTY_HEIGHT; c++)
+    {
+        char line[] = {c, '\n', '\0'};
+        write(line);
+    }
+
+    write("end");
+
+    CHECK_ROW(0, "B");
+    CHECK_ROW(TTY_HEIGHT - 2, "X");
+    CHECK_ROW(TTY_HEIGHT - 1, "end");
+    CHECK_CURSOR(TTY_HEIGHT - 1, 3);
+    TEST_CHECK_EQ(char_at(0, TTY_HEIGHT), '>');
+}
+
+static void test_cursor_position(void)
+{
+    reset();
+    write("\x1b[5;10HX");
+
+    TEST_CHECK_EQ(char_at(9, 4), 'X');
+    CHECK_CURSOR(4, 10);
+
+    write("\x1b[H");
+    CHECK_CURSOR(0, 0);
+
+    // positions are kept on the screen above the scratchpad
+    write("\x1b[99;999H");
+    CHECK_CURSOR(TTY_HEIGHT - 1, VGA_WIDTH - 1);
+
+    write("\x1b[3;3H\x1b[2A\x1b[5C\x1b[B\x1b[2D");
+    CHECK_CURSOR(1, 5);
+
+    write("\x1b[s\x1b[10;10H\x1b[u");
+    CHECK_CURSOR(1, 5);
+}
+
+/// @brief Fills the tty with 'a's
+static void fill(void)
+{
+    reset();
+
+    for (int y = 0; y < TTY_HEIGHT; y++)
+    {
+        write("\x1b[");
+        char row[3] = {'0' + (y + 1) / 10, '0' + (y + 1) % 10, '\0'};
+        write(row);
+        write("H");
+
+        char line[VGA_WIDTH];
+        memset(line, 'a', sizeof(line));
+        tty_write(&tty, line, y == TTY_HEIGHT - 1 ? VGA_WIDTH - 1 : VGA_WIDTH);
+    }
+}
+
+static void test_erase_display(void)
+{
+    fill();
+    write("\x1b[3;5H\x1b[J");
+
+    CHECK_ROW(1, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaa");
+    CHECK_ROW(2, "aaaa");
+    CHECK_ROW(TTY_HEIGHT - 1, "");
+    CHECK_CURSOR(2, 4);
+
+    fill();
+    write("\x1b[2;3H\x1b[1J");
+
+    CHECK_ROW(0, "");
+    TEST_CHECK_EQ(char_at(2, 1), ' ');
+    TEST_CHECK_EQ(char_at(3, 1), 'a');
+
+    fill();
+    write("\x1b[2J");
+
+    for (int y = 0; y < TTY_HEIGHT; y++)
+    {
+        CHECK_ROW(y, "");
+    }
+}
+
+static void test_erase_line(void)
+{
+    reset();
+    write("abcdef\x1b[1;3H\x1b[K");
+    CHECK_ROW(0, "ab");
+
+    write("\rabcdef\x1b[1;3H\x1b[1K");
+    CHECK_ROW(0, "   def");
+
+    write("\x1b[2K");
+    CHECK_ROW(0, "");
+    CHECK_CURSOR(0, 2);
+}
+
+static void test_colors(void)
+{
+    reset();
+    write("\x1b[31;44mA\x1b[0mB\x1b[1;32mC\x1b[97;100mD\x1b[mE\x1b[33m\x1b[22mF");
+
+    // ANSI red and blue are VGA's 4 and 1
+    TEST_CHECK_EQ(cell_at(0, 0), 0x1400 | 'A');
+    TEST_CHECK_EQ(cell_at(1, 0), DEFAULT_ATTRIBUTE | 'B');
+    TEST_CHECK_EQ(cell_at(2, 0), 0x0A00 | 'C');
+    TEST_CHECK_EQ(cell_at(3, 0), 0x8F00 | 'D');
+    TEST_CHECK_EQ(cell_at(4, 0), DEFAULT_ATTRIBUTE | 'E');
+    TEST_CHECK_EQ(cell_at(5, 0), 0x0600 | 'F');
+
+    // erasing uses the current background
+    write("\x1b[42m\x1b[K");
+    TEST_CHECK_EQ(cell_at(6, 0), 0x2600 | ' ');
+}
+
+static void test_scroll_region(void)
+{
+    reset();
+    write("top\x1b[5;1Hbottom\x1b[2;4r");
+
+    // setting the region moves the cursor home
+    CHECK_CURSOR(0, 0);
+
+    write("\x1b[4;1H1\n2\n3\n4");
+
+    CHECK_ROW(0, "top");
+    CHECK_ROW(1, "2");
+    CHECK_ROW(2, "3");
+    CHECK_ROW(3, "4");
+    CHECK_ROW(4, "bottom");
+
+    // below the region, the last row doesn't scroll
+    write("\x1b[r\x1b[24;1Hx\x1b[2;3r\x1b[24;1H\n");
+    CHECK_ROW(TTY_HEIGHT - 1, "x");
+    CHECK_CURSOR(TTY_HEIGHT - 1, 0);
+
+    // invalid regions are ignored
+    write("\x1b[r\x1b[5;5r\x1b[3;2r\x1b[1;99r");
+    TEST_CHECK_EQ(tty.scroll_top, 0);
+    TEST_CHECK_EQ(tty.scroll_bottom, TTY_HEIGHT);
+}
+
+static void test_split_sequences(void)
+{
+    const char *sequence = "\x1b[31mR\x1b[10;20H";
+
+    reset();
+
+    for (const char *c = sequence; *c; c++)
+    {
+        tty_write(&tty, c, 1);
+    }
+
+    TEST_CHECK_EQ(cell_at(0, 0), 0x0400 | 'R');
+    CHECK_CURSOR(9, 19);
+
+    write("\x1b[1");
+    write("2;3");
+    write("4HZ");
+    TEST_CHECK_EQ(char_at(33, 11), 'Z');
+}
+
+static void test_private_sequences(void)
+{
+    reset();
+
+    write("\x1b[?25h");
+    TEST_CHECK(tty.cursor_visible);
+
+    write("\x1b[?25l");
+    TEST_CHECK(!tty.cursor_visible);
+
+    // unknown sequences are dropped whole, the text after them is written
+    write("\x1b[?1049hok\x1b[5zok\x1b(Bok");
+    CHECK_ROW(0, "okokBok");
+}
+
+void test_tty_suite(void)
+{
+    TEST_RUN(test_plain_text);
+    TEST_RUN(test_wrapping);
+    TEST_RUN(test_scrolling);
+    TEST_RUN(test_cursor_position);
+    TEST_RUN(test_erase_display);
+    TEST_RUN(test_erase_line);
+    TEST_RUN(test_colors);
+    TEST_RUN(test_scroll_region);
+    TEST_RUN(test_split_sequences);
+    TEST_RUN(test_private_sequences);
+}
@@ -0,0 +1,62 @@
+/// Microbenchmarks
+///
+/// Benchmarks are defined with `DEFINE_BENCH` anywhere in the kernel, which
+/// places their descriptors in the `.benches` section, so the `bench` command
+/// finds all of them without a registration call.
+///
+/// Each sample times a single `run` call with serialized TSC reads, after a
+/// few warm-up calls, and with interrupts disabled. The timer's own overhead is
+/// measured once and subtracted. `bench <name|all>` prints the minimum, median
+/// and 99th percentile of the samples, and writes them to the serial line as
+/// CSV between `# bench begin` and `# bench end` lines. Benchmarks that process
+/// a known amount of items per `run` also get their median throughput printed.
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+/// @brief The default amount of samples taken of every benchmark
+#define BENCH_SAMPLES 256
+
+/// @brief The amount of `run` calls before the samples are taken
+#define BENCH_WARMUP 16
+
+typedef struct
+{
+    const char *name;
+    /// @brief Called once before the warm-up, may be `NULL`
+    void (*setup)(void);
+    /// @brief The measured operation
+    void (*run)(void);
+    /// @brief Called once after the last sample, may be `NULL`
+    void (*teardown)(void);
+    /// @brief The amount of samples, `BENCH_SAMPLES` when `0`
+    uint32_t samples;
+    /// @brief The amount of items, e.g. characters, that a `run` call
+    ///        processes, or `0` if there's no such amount
+    uint32_t items;
+} bench_t;
+
+/// @brief Defines the benchmark `bench_name`, e.g.
+///        `DEFINE_BENCH(memcpy_ram, .run = bench_memcpy_ram);`
+#define DEFINE_BENCH(bench_name, ...)                                          \
+    static const bench_t __bench_##bench_name                                  \
+        __attribute__((section(".benches"), used, aligned(4))) = {             \
+            .name = #bench_name,                                               \
+            __VA_ARGS__}
+
+typedef struct
+{
+    uint32_t samples;
+    uint32_t min;
+    uint32_t median;
+    uint32_t p99;
+} bench_result_t;
+
+/// @brief Runs the benchmark and returns its statistics, in TSC cycles
+void bench_run(const bench_t *bench, bench_result_t *result);
+
+/// @brief Returns the benchmark called `name`, or `NULL`
+const bench_t *bench_find(const char *name);
+
+#endif
@@ -0,0 +1,37 @@
+/// Boot timeline
+///
+/// `_start` stores the TSC before anything else runs, and `kernel_main` wraps
+/// each of its setup stages in `BOOT_STAGE`, which records when the stage
+/// started and ended. The `boottime` command prints the timeline,
+/// `boottime csv` writes it to the serial line so that boot times can be
+/// compared across builds.
+#ifndef BOOTTIME_H
+#define BOOTTIME_H
+
+#include <random.h>
+#include <stdint.h>
+
+/// @brief The maximum amount of stages in the boot log
+#define BOOT_STAGES_MAX 32
+
+/// @brief The TSC value read by the first instruction of `_start`
+extern uint64_t boot_tsc_start;
+
+/// @brief Adds a stage to the boot log
+/// @param name The stage's name, which has to outlive the log
+void boot_stage_record(const char *name, uint64_t start, uint64_t end);
+
+/// @brief Marks the end of the boot, i.e. the moment the scheduler takes over
+void boot_finished(void);
+
+/// @brief Calls `function` and records how long it took as a boot stage named
+///        after it
+#define BOOT_STAGE(function)                                                   \
+    do                                                                         \
+    {                                                                          \
+        uint64_t boot_stage_start = rdtsc();                                   \
+        function();                                                            \
+        boot_stage_record(#function, boot_stage_start, rdtsc());               \
+    } while (0)
+
+#endif
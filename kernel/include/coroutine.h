@@ -0,0 +1,145 @@
+/// Stackless cooperative coroutines
+///
+/// A coroutine is a plain function that is re-entered from the top every time
+/// it is resumed. `co_begin` jumps to the point at which it was last suspended
+/// (protothread style, with a `switch` over the suspension line),
+/// so the function body reads like a blocking loop even though it returns to
+/// the scheduler at every `co_yield`, `co_sleep` and `co_await_event`.
+///
+/// Because there is no per-coroutine stack, local variables do NOT survive a
+/// suspension. Everything that must be kept across a suspension point has to
+/// live in the structure pointed to by `coroutine_t.data`.
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <fpu.h>
+#include <random.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief An event that coroutines can wait on with `co_await_event`.
+///
+/// Every `co_event_signal` is counted and consumed by exactly one
+/// `co_await_event`, so signals raised while nobody is waiting are not lost.
+/// Signalling is safe from interrupt handlers.
+typedef struct
+{
+    volatile uint32_t pending;
+} co_event_t;
+
+typedef enum
+{
+    CO_READY,
+    CO_SLEEPING,
+    CO_WAITING,
+    CO_DONE,
+} co_state_t;
+
+typedef struct coroutine coroutine_t;
+
+/// @brief The body of a coroutine. Must start with `co_begin` and end with
+///        `co_end`.
+typedef void (*coroutine_fn_t)(coroutine_t *co);
+
+struct coroutine
+{
+    coroutine_fn_t fn;
+    /// @brief User data, the only storage that survives suspensions
+    void *data;
+    const char *name;
+
+    /// @brief The line at which the coroutine was suspended, or `0` when it
+    ///        was not started yet
+    uint32_t resume_line;
+    co_state_t state;
+    /// @brief TSC value after which a sleeping coroutine becomes ready
+    uint64_t wake_time;
+    /// @brief The event that a waiting coroutine waits on
+    co_event_t *event;
+
+    /// @brief Amount of times the coroutine was resumed
+    uint32_t resumes;
+    /// @brief Total TSC cycles spent inside the coroutine
+    uint64_t cycles;
+
+    /// @brief The coroutine's FPU state, `NULL` until it uses the FPU
+    fpu_context_t *fpu;
+
+    coroutine_t *next;
+};
+
+/// @brief Adds the coroutine to the scheduler. It will be first resumed on the
+///        next scheduler pass.
+///
+/// The coroutine structure must stay valid until the coroutine finishes.
+void coroutine_spawn(coroutine_t *co, const char *name, coroutine_fn_t fn,
+                     void *data);
+
+/// @brief Returns whether the coroutine is spawned and did not finish yet
+bool coroutine_is_running(coroutine_t *co);
+
+/// @brief Resumes every coroutine that is ready to run once.
+/// @returns Whether any coroutine was resumed
+bool coroutines_run(void);
+
+/// @brief Runs the coroutine scheduler forever, halting the CPU whenever no
+///        coroutine is ready to run.
+__attribute__((__noreturn__)) void scheduler_loop(void);
+
+/// @brief Signals the event, waking up one of its waiters.
+void co_event_signal(co_event_t *event);
+
+/// @brief Consumes one pending signal of the event, if there is any.
+/// @returns Whether a signal was consumed
+bool co_event_try_consume(co_event_t *event);
+
+/// Suspends the coroutine after running `prepare`. The coroutine continues
+/// right after this macro when it's resumed. The resume point is identified by
+/// `__LINE__`, so there can only be one suspension point per line and
+/// suspension points cannot be placed inside `switch` statements.
+#define CO_SUSPEND(co, prepare)                                                \
+    do                                                                         \
+    {                                                                          \
+        prepare;                                                               \
+        (co)->resume_line = __LINE__;                                          \
+        return;                                                                \
+    case __LINE__:;                                                            \
+    } while (0)
+
+/// @brief Must be the first statement of a coroutine body
+#define co_begin(co)                                                           \
+    switch ((co)->resume_line)                                                 \
+    {                                                                          \
+    case 0:
+
+/// @brief Must be the last statement of a coroutine body. Finishes the
+///        coroutine, which will be removed from the scheduler.
+#define co_end(co)                                                             \
+    }                                                                          \
+    (co)->state = CO_DONE;                                                     \
+    return
+
+/// @brief Gives the other coroutines a chance to run
+#define co_yield(co) CO_SUSPEND(co, (co)->state = CO_READY)
+
+/// @brief Suspends the coroutine for at least `cycles` TSC cycles
+#define co_sleep(co, cycles)                                                   \
+    CO_SUSPEND(co, ((co)->state = CO_SLEEPING,                                 \
+                    (co)->wake_time = rdtsc() + (cycles)))
+
+/// @brief Suspends the coroutine until the TSC reaches `time`. Unlike
+///        `co_sleep`, repeated sleeps on a fixed period do not accumulate drift.
+#define co_sleep_until(co, time)                                               \
+    CO_SUSPEND(co, ((co)->state = CO_SLEEPING, (co)->wake_time = (time)))
+
+/// @brief Suspends the coroutine until the event is signalled
+#define co_await_event(co, ev)                                                 \
+    do                                                                         \
+    {                                                                          \
+        while (!co_event_try_consume(ev))                                      \
+        {                                                                      \
+            CO_SUSPEND(co, ((co)->state = CO_WAITING, (co)->event = (ev)));    \
+        }                                                                      \
+    } while (0)
+
+#endif
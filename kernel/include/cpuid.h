@@ -0,0 +1,43 @@
+/// The `cpuid` instruction
+#ifndef CPUID_H
+#define CPUID_H
+
+#include <stdint.h>
+
+/// @brief Leaf 1: processor features
+#define CPUID_FEATURES 1
+
+/// @brief Leaf 1 EDX: the time stamp counter
+#define CPUID_EDX_TSC (1 << 4)
+/// @brief Leaf 1 EDX: `fxsave` and `fxrstor`
+#define CPUID_EDX_FXSR (1 << 24)
+/// @brief Leaf 1 EDX: SSE
+#define CPUID_EDX_SSE (1 << 25)
+/// @brief Leaf 1 EDX: SSE2, which also brings `lfence`
+#define CPUID_EDX_SSE2 (1 << 26)
+
+typedef struct
+{
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+} cpuid_t;
+
+/// @brief Executes `cpuid` for the leaf. Also serializes the instruction
+///        stream: every earlier instruction completes before it, no later one
+///        starts before it finishes.
+static inline cpuid_t cpuid(uint32_t leaf)
+{
+    cpuid_t regs;
+
+    __asm__ volatile("cpuid"
+                     : "=a"(regs.eax), "=b"(regs.ebx), "=c"(regs.ecx),
+                       "=d"(regs.edx)
+                     : "a"(leaf), "c"(0)
+                     : "memory");
+
+    return regs;
+}
+
+#endif
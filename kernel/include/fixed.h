@@ -0,0 +1,109 @@
+/// Q16.16 fixed-point arithmetic
+///
+/// Code that needs fractions uses `fixed_t` instead of `float`: a signed 32-bit
+/// integer counting 1/65536ths. The arithmetic is exact integer math, so it
+/// gives the same results on every run and machine, which the simulations'
+/// trajectory checks rely on. It also keeps the games' coroutines off the FPU,
+/// so switching to them never raises #NM nor needs a 512-byte save area, see
+/// fpu.h. The arithmetic saturates at `FIXED_MIN` and `FIXED_MAX` rather than
+/// wrapping around.
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdint.h>
+
+typedef int32_t fixed_t;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE ((fixed_t)1 << FIXED_SHIFT)
+#define FIXED_MAX ((fixed_t)INT32_MAX)
+#define FIXED_MIN ((fixed_t)INT32_MIN)
+
+/// @brief The integer `n` as a constant, e.g. `FIXED_INT(3)`
+#define FIXED_INT(n) ((fixed_t)((n) * FIXED_ONE))
+
+/// @brief The fraction `num / den` as a constant, e.g. `FIXED_RATIO(1, 2)`
+#define FIXED_RATIO(num, den) ((fixed_t)(((int64_t)(num) * FIXED_ONE) / (den)))
+
+static inline fixed_t fixed_saturate(int64_t value)
+{
+    if (value > FIXED_MAX)
+    {
+        return FIXED_MAX;
+    }
+
+    if (value < FIXED_MIN)
+    {
+        return FIXED_MIN;
+    }
+
+    return (fixed_t)value;
+}
+
+static inline fixed_t fixed_from_int(int32_t value)
+{
+    return fixed_saturate((int64_t)value << FIXED_SHIFT);
+}
+
+/// @brief Rounds towards negative infinity
+static inline int32_t fixed_to_int(fixed_t value)
+{
+    return value >> FIXED_SHIFT;
+}
+
+static inline fixed_t fixed_add_sat(fixed_t lhs, fixed_t rhs)
+{
+    return fixed_saturate((int64_t)lhs + rhs);
+}
+
+static inline fixed_t fixed_sub_sat(fixed_t lhs, fixed_t rhs)
+{
+    return fixed_saturate((int64_t)lhs - rhs);
+}
+
+/// @brief Multiplies, rounding the product towards negative infinity
+static inline fixed_t fixed_mul_sat(fixed_t lhs, fixed_t rhs)
+{
+    return fixed_saturate(((int64_t)lhs * rhs) >> FIXED_SHIFT);
+}
+
+static inline fixed_t fixed_clamp(fixed_t value, fixed_t min, fixed_t max)
+{
+    if (value >= max)
+    {
+        return max;
+    }
+
+    if (value <= min)
+    {
+        return min;
+    }
+
+    return value;
+}
+
+/// @brief Interpolates from `from` at `t = 0` to `to` at `t = FIXED_ONE`
+static inline fixed_t fixed_lerp(fixed_t from, fixed_t to, fixed_t t)
+{
+    int64_t distance = (int64_t)to - from;
+
+    return fixed_saturate(from + ((distance * t) >> FIXED_SHIFT));
+}
+
+/// @brief Returns `num / den`, e.g. an amount of elapsed cycles as a fraction
+///        of a period, `den` has to be below 2^48
+static inline fixed_t fixed_ratio(uint64_t num, uint64_t den)
+{
+    uint64_t whole = num / den;
+
+    if (whole > (uint64_t)FIXED_MAX >> FIXED_SHIFT)
+    {
+        return FIXED_MAX;
+    }
+
+    uint64_t fraction = ((num % den) << FIXED_SHIFT) / den;
+
+    return (fixed_t)((whole << FIXED_SHIFT) | fraction);
+}
+
+#endif
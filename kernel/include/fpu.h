@@ -0,0 +1,56 @@
+/// Lazy x87/SSE state switching
+///
+/// The FPU registers hold the state of a single context, the owner. Switching
+/// to another context only sets CR0.TS, and the first FPU or SSE instruction
+/// executed with TS set raises #NM (vector 7), whose handler saves the owner's
+/// state into its area, loads the new context's one and clears TS. Contexts
+/// that never touch the FPU never trap and never get an area.
+///
+/// Every coroutine is a context, the code running outside of any coroutine
+/// (the boot code and the scheduler loop) is another one. Interrupt handlers
+/// must wrap any FPU or SSE use in `kernel_fpu_begin` and `kernel_fpu_end`.
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief The area `fxsave` writes to, `fnsave` uses its first 108 bytes
+typedef struct
+{
+    uint8_t bytes[512];
+} __attribute__((aligned(16))) fpu_state_t;
+
+typedef struct fpu_context
+{
+    fpu_state_t state;
+    bool in_use;
+} fpu_context_t;
+
+/// @brief The amount of contexts that can have used the FPU at once
+#define FPU_CONTEXTS 8
+
+/// @brief Enables the FPU and SSE with TS set, so the first use traps
+void setup_fpu(void);
+
+/// @brief Makes `context` the current context, called before running a
+///        coroutine. `*context` is `NULL` until the context uses the FPU.
+///        A `NULL` `context` switches back to the context outside coroutines.
+void fpu_switch(fpu_context_t **context);
+
+/// @brief Drops the context's FPU state and frees its area
+void fpu_release(fpu_context_t **context);
+
+/// @brief Called from the #NM handler
+void fpu_device_not_available(void);
+
+/// @brief Lets the kernel use the FPU and SSE registers until
+///        `kernel_fpu_end`, from any context, including interrupt handlers.
+///        The current owner's state is saved first and interrupts are
+///        disabled in-between, so the sections should be short and can't
+///        nest.
+void kernel_fpu_begin(void);
+
+void kernel_fpu_end(void);
+
+#endif
@@ -0,0 +1,118 @@
+/// Fixed-timestep game runtime
+///
+/// A game is a pair of callbacks that the runtime drives from a coroutine on
+/// the game's tty. `update` advances the game by a fixed step of game time,
+/// `render` draws it into a canvas.
+///
+/// The game time runs in step-sized increments ahead of the TSC: the
+/// coroutine sleeps until the next step is due, then runs every step whose
+/// time has come, so a late frame catches up with several updates instead of
+/// stretching a step. Every frame hands the same snapshot of the keyboard to
+/// its updates, with the keys pressed since the previous frame and the keys
+/// held down. After the updates, the canvas is rendered and only the cells
+/// that changed are written to the tty.
+///
+/// When the game ends, the kernel tty is activated again and the frame times
+/// are printed as a histogram.
+#ifndef GAME_H
+#define GAME_H
+
+#include <coroutine.h>
+#include <histogram.h>
+#include <input.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <tty.h>
+
+/// @brief The most updates a frame catches up with, the game time skips
+///        ahead after a longer stall
+#define GAME_MAX_STEPS_PER_FRAME 5
+
+/// @brief The amount of scancodes that the input snapshots cover
+#define GAME_KEYS 128
+
+/// @brief The keyboard as seen by the updates of a frame
+typedef struct
+{
+    /// @brief The keys pressed since the previous frame
+    uint32_t pressed[GAME_KEYS / 32];
+    /// @brief The keys held down at the start of the frame
+    uint32_t held[GAME_KEYS / 32];
+} game_input_t;
+
+static inline bool game_key_pressed(const game_input_t *input, keys_t key)
+{
+    return key < GAME_KEYS && (input->pressed[key / 32] >> (key % 32)) & 1;
+}
+
+static inline bool game_key_held(const game_input_t *input, keys_t key)
+{
+    return key < GAME_KEYS && (input->held[key / 32] >> (key % 32)) & 1;
+}
+
+/// @brief The cells a game renders into, in the VGA format
+typedef struct
+{
+    uint16_t cells[BUFFER_SIZE];
+    /// @brief The cells as of the last `game_canvas_present`. The tty's
+    ///        buffer may be VGA memory, which is slow to read.
+    uint16_t shown[BUFFER_SIZE];
+} game_canvas_t;
+
+/// @brief Sets every cell of the canvas
+void game_canvas_fill(game_canvas_t *canvas, char c,
+                      terminal_entry_color_t color);
+
+/// @brief Sets the cell at `x, y`, if it's on the screen
+void game_canvas_put(game_canvas_t *canvas, int32_t x, int32_t y, char c,
+                     terminal_entry_color_t color);
+
+/// @brief Writes the cells that changed since the last time to the tty, and
+///        flushes the tty if there were any
+/// @returns The amount of written cells
+uint32_t game_canvas_present(game_canvas_t *canvas, tty_t *tty);
+
+typedef struct
+{
+    const char *name;
+    /// @brief The game time that every update advances, in microseconds
+    uint32_t step_us;
+    /// @brief Advances the game by a step
+    /// @returns Whether the game goes on
+    bool (*update)(void *state, const game_input_t *input);
+    /// @brief Draws the game as of the last update. The canvas keeps what
+    ///        was rendered into it the previous frame.
+    void (*render)(void *state, game_canvas_t *canvas);
+} game_t;
+
+/// @brief A running game, which has to stay valid until the game ends
+typedef struct
+{
+    const game_t *game;
+    void *state;
+    tty_t *tty;
+    coroutine_t co;
+
+    game_canvas_t canvas;
+    /// @brief The keys pressed since the last frame
+    game_input_t input;
+
+    uint64_t step_cycles;
+    /// @brief The TSC value at which the next step is due
+    uint64_t next_step;
+    uint64_t last_frame;
+    histogram_t frame_times;
+} game_runtime_t;
+
+/// @brief Activates the tty and runs the game on it until `update` returns
+///        `false`. The canvas starts out blank, and the tty must not be
+///        written to by anything else while the game runs.
+/// @returns Whether the game was started, `false` if the runtime is still
+///          running a game
+bool game_start(game_runtime_t *runtime, const game_t *game, void *state,
+                tty_t *tty);
+
+/// @brief Returns whether the runtime is running a game
+bool game_is_running(game_runtime_t *runtime);
+
+#endif
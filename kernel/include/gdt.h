@@ -1,9 +1,32 @@
 #ifndef GDT_H
 #define GDT_H
 
+#include <stdint.h>
+
 void setup_gdt(void);
 
+/// @brief Fills the task state segments and loads the kernel's one. Double
+///        faults and NMIs get their own tasks, so they run on their own stacks
+///        even if the kernel stack is exhausted. Must be called after the IDT
+///        and paging are set up.
+void setup_tss(void);
+
+/// @brief Returns the base address of the TSS with the provided index
+uint32_t tss_base(int index);
+
+/// @brief Returns the limit of every TSS
+uint32_t tss_limit(void);
+
 #define KERNEL_CS 0x08
 #define KERNEL_DS 0x10
 
+#define TSS_INDEX_KERNEL 0
+#define TSS_INDEX_DOUBLE_FAULT 1
+#define TSS_INDEX_NMI 2
+#define TSS_COUNT 3
+
+#define TSS_KERNEL 0x28
+#define TSS_DOUBLE_FAULT 0x30
+#define TSS_NMI 0x38
+
 #endif
\ No newline at end of file
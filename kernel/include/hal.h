@@ -0,0 +1,79 @@
+/// Hardware abstraction
+///
+/// The few places outside of `cpu/` that touch the hardware directly - VGA
+/// memory, the interrupt flag and halting - go through these functions, the
+/// port I/O through `inb` and `outb`. The kernel implements them with the
+/// real instructions. The host build (`HOST_BUILD`, see `host/`) emulates
+/// them, so the tty, the scratchpad, `printf` and the benchmarks run as a
+/// Linux program.
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+/// The interrupt flag in EFLAGS
+#define EFLAGS_IF (1 << 9)
+
+#ifdef HOST_BUILD
+
+/// @brief Stands in for the VGA text buffer
+extern uint16_t hal_vga_memory[];
+
+/// @brief The emulated EFLAGS, only `EFLAGS_IF` is used
+extern uint32_t hal_eflags;
+
+#define VGA_MEMORY ((uintptr_t)hal_vga_memory)
+
+static inline uint32_t hal_save_flags_cli(void)
+{
+    uint32_t flags = hal_eflags;
+    hal_eflags &= ~EFLAGS_IF;
+    return flags;
+}
+
+static inline void hal_sti(void)
+{
+    hal_eflags |= EFLAGS_IF;
+}
+
+/// @brief Nothing interrupts a host program, so waiting would never end
+static inline void hal_sti_hlt(void)
+{
+    hal_eflags |= EFLAGS_IF;
+}
+
+#else
+
+#define VGA_MEMORY 0xB8000
+
+/// @brief Disables interrupts and returns the EFLAGS from before
+static inline uint32_t hal_save_flags_cli(void)
+{
+    uint32_t flags;
+
+    __asm__ volatile("pushf\n\t"
+                     "pop %0\n\t"
+                     "cli"
+                     : "=r"(flags)
+                     :
+                     : "memory");
+
+    return flags;
+}
+
+static inline void hal_sti(void)
+{
+    __asm__ volatile("sti" : : : "memory");
+}
+
+/// @brief Enables interrupts and waits for the next one. `sti` only takes
+///        effect after the next instruction, so no interrupt can arrive
+///        before the `hlt`.
+static inline void hal_sti_hlt(void)
+{
+    __asm__ volatile("sti; hlt" : : : "memory");
+}
+
+#endif
+
+#endif
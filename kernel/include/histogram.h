@@ -0,0 +1,49 @@
+/// Log2 histograms of cycle counts
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/// @brief The amount of buckets. Bucket `0` counts zeros, bucket `n` the
+///        values in `[2^(n-1), 2^n)`. The last bucket also counts everything
+///        larger.
+#define HISTOGRAM_BUCKETS 40
+
+typedef struct
+{
+    uint32_t count;
+    /// @brief The largest value, saturated to 32 bits
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[HISTOGRAM_BUCKETS];
+} histogram_t;
+
+/// @brief Returns the bucket that counts `value`
+static inline uint32_t histogram_bucket(uint64_t value)
+{
+    if (value == 0)
+    {
+        return 0;
+    }
+
+    uint32_t bucket = 64 - __builtin_clzll(value);
+
+    return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+}
+
+void histogram_add(histogram_t *histogram, uint64_t value);
+
+/// @brief Returns the average of the added values
+uint32_t histogram_average(const histogram_t *histogram);
+
+/// @brief Returns the bucket that contains the `percent`th percentile
+uint32_t histogram_percentile(const histogram_t *histogram, uint32_t percent);
+
+/// @brief Prints the bucket's range, e.g. `<2^10`
+void histogram_print_bucket(uint32_t bucket);
+
+/// @brief Prints the non-empty buckets as horizontal bars
+/// @param title Printed above the bars
+void histogram_print(const histogram_t *histogram, const char *title);
+
+#endif
@@ -1,19 +1,19 @@
 #ifndef IDT_H
 #define IDT_H
 
+#include <stdint.h>
+
 /// @brief Sets up the IDT (interrupt descriptor table),
 ///        letting the CPU execute interrupts again.
 void setup_idt(void);
 
-/// @brief Pauses ISRs (interrup service routines).
-///        No interrupts will be executed if ISR is paused.
-void isr_pause(void);
+/// @brief Makes the interrupt `vector` switch to the task described by the TSS
+///        with the provided GDT selector.
+void idt_set_task_gate(uint8_t vector, uint16_t tss_selector);
 
-/// @brief Resumes ISRs (interrupt service routines).
-///        Undoes what `isr_pause` does - interrupts will be
-///        executed again. The interrupts that were "skipped"
-///        because of an interrupt service routine pause will
-///        not be executed.
+/// @brief Resumes ISRs (interrupt service routines), i.e. enables interrupts
+///        unconditionally. Code that disables interrupts uses `irq_save` and
+///        `irq_restore` instead, which nest.
 void isr_resume(void);
 
 #endif
\ No newline at end of file
@@ -4,7 +4,10 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-typedef void (*scratchpad_cmd_callback_t)();
+/// @brief A command's callback
+/// @param args The rest of the command line after the command's name, without
+///             the leading spaces. Empty when no arguments were provided.
+typedef void (*scratchpad_cmd_callback_t)(const char *args);
 
 typedef struct
 {
@@ -16,6 +19,13 @@ typedef struct
 void setup_input();
 void add_command(scratchpad_cmd_t cmd);
 
+/// @brief Executes the command line as if it was typed into the scratchpad
+/// @param line The null-terminated command line
+void execute_command(const char *line);
+
+/// @brief Starts executing commands received over the serial line
+void start_serial_console();
+
 // clang-format off
 
 typedef enum {
@@ -124,4 +134,18 @@ typedef enum
 
 // clang-format on
 
+/// @brief A key press or release, as received from the keyboard
+typedef struct
+{
+    /// @brief TSC value at the moment the keyboard interrupt was handled
+    uint64_t timestamp;
+    /// @brief Sequence number of the event. Carried to the `tty_flush` that
+    ///        shows the event's effect, see `tty_mark_input`.
+    uint32_t id;
+    /// @brief Modifiers present after handling the event (`modifiers_t` flags)
+    uint16_t modifiers;
+    keys_t key;
+    bool pressed;
+} key_event_t;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+/// Keypress-to-screen latency
+///
+/// Every key event is stamped with the TSC when the keyboard interrupt handles
+/// it. The handler that reacts to the event marks the tty with it
+/// (`tty_mark_input`), and the next `tty_flush` of that tty - the one that
+/// writes the effect to VGA memory - records how long it took. The `inputlat`
+/// command prints the histograms, `inputlat test` measures them with injected
+/// keystrokes.
+#ifndef INPUTLAT_H
+#define INPUTLAT_H
+
+#include <input.h>
+#include <stdint.h>
+
+/// @brief Called by the keyboard dispatcher before handing the event over to
+///        the active tty
+void input_latency_dispatched(const key_event_t *event);
+
+/// @brief Called by `tty_flush` after writing the effect of the event to VGA
+///        memory
+/// @param id The event's `id`
+/// @param timestamp The event's `timestamp`
+void input_latency_flushed(uint32_t id, uint64_t timestamp);
+
+#endif
@@ -0,0 +1,62 @@
+/// Hardware interrupt handler registration and dispatch
+///
+/// Hardware interrupts don't go through the generic `interrupt_handler`. Their
+/// stubs only save the caller-saved registers and call `irq_dispatch`, which
+/// looks the handlers up in a table indexed by the vector.
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief The vector of the first PIC interrupt (IRQ0)
+#define IRQ_VECTOR_BASE 32
+
+/// @brief The amount of PIC interrupt lines
+#define IRQ_LINES 16
+
+/// @brief Returns the vector that the PIC raises for the IRQ line `irq`
+#define IRQ_VECTOR(irq) (IRQ_VECTOR_BASE + (irq))
+
+/// @brief A software-only vector dispatched through the fast path. Used to
+///        measure the interrupt round trip.
+#define IRQ_VECTOR_SELFTEST 48
+
+/// @brief A software-only vector dispatched through the generic exception
+///        path, for comparison with `IRQ_VECTOR_SELFTEST`.
+#define IRQ_VECTOR_SELFTEST_GENERIC 49
+
+/// @brief The amount of vectors the dispatch table covers
+#define IRQ_VECTOR_COUNT 50
+
+/// @brief An interrupt handler.
+///
+/// Several handlers may share a vector, in which case all of them are called.
+///
+/// @param ctx The context passed to `irq_register`
+/// @returns Whether the handler's device raised the interrupt
+typedef bool (*irq_handler_t)(void *ctx);
+
+/// @brief The state saved by the fast-path stubs
+typedef struct
+{
+    uint32_t ebp, ebx, edx, ecx, eax;
+    uint32_t vector;
+    uint32_t eip, cs, eflags;
+} irq_frame_t;
+
+/// @brief Registers a handler for the interrupt vector. PIC interrupts are
+///        acknowledged by the dispatcher, handlers must not call `pic_eoi`.
+///
+/// @returns Whether the handler was registered. Fails if the vector is out of
+///          range or too many handlers were registered.
+bool irq_register(uint8_t vector, irq_handler_t handler, void *ctx);
+
+/// @brief Called by the fast-path stubs for every hardware interrupt
+void irq_dispatch(irq_frame_t *frame);
+
+/// @brief Returns the state of the code interrupted by the hardware interrupt
+///        that's being handled. Only valid inside of a handler.
+irq_frame_t *irq_get_regs(void);
+
+#endif
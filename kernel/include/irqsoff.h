@@ -0,0 +1,65 @@
+/// Interrupts-off latency tracer
+///
+/// When the kernel is built with `IRQSOFF_TRACE`, every section of code that
+/// runs with interrupts disabled is timed: from the `irq_save` that disabled
+/// them to the matching `irq_restore`, or to `isr_resume`, as well
+/// as interrupt handlers themselves. Each CPU keeps the longest sections along
+/// with the address of the code that disabled interrupts, which bounds the
+/// latency of every interrupt, keyboard input included.
+///
+/// The `irqsoff` command prints them, and can log or panic when a section is
+/// longer than a threshold.
+#ifndef IRQSOFF_H
+#define IRQSOFF_H
+
+#include <stdint.h>
+
+/// @brief The address of the instruction that uses it, e.g. the address inside
+///        of the function that an inline function was inlined into
+#define THIS_IP                                                                \
+    ({                                                                         \
+        uintptr_t ip;                                                          \
+        __asm__("1: mov $1b, %0" : "=r"(ip));                                  \
+        ip;                                                                    \
+    })
+
+#ifdef IRQSOFF_TRACE
+
+/// @brief Starts timing an interrupts-off section. Must be called with
+///        interrupts already disabled, only when they were enabled before.
+/// @param caller The address of the code that disabled interrupts
+void irqsoff_begin(uintptr_t caller);
+
+/// @brief Ends the section started by `irqsoff_begin`. Must be called right
+///        before interrupts are enabled again.
+void irqsoff_end(void);
+
+/// @brief Records the time an interrupt handler ran for, if it interrupted
+///        code that ran with interrupts enabled
+/// @param eflags The interrupted code's EFLAGS
+void irqsoff_record_interrupt(uint32_t vector, uint32_t eflags, uint64_t entry,
+                              uint64_t exit);
+
+#else
+
+static inline void irqsoff_begin(uintptr_t caller)
+{
+    (void)caller;
+}
+
+static inline void irqsoff_end(void)
+{
+}
+
+static inline void irqsoff_record_interrupt(uint32_t vector, uint32_t eflags,
+                                            uint64_t entry, uint64_t exit)
+{
+    (void)vector;
+    (void)eflags;
+    (void)entry;
+    (void)exit;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,19 @@
+/// Interrupt statistics
+///
+/// Every CPU keeps, for each interrupt vector, the amount of interrupts and
+/// log2 histograms of the handler's duration and of the time between two
+/// consecutive interrupts, both in TSC cycles. The `irqstat` command prints
+/// them, `irqstat csv` exports them over the serial line.
+#ifndef IRQSTAT_H
+#define IRQSTAT_H
+
+#include <stdint.h>
+
+/// @brief Records a handled interrupt. Must be called with interrupts
+///        disabled, on the CPU that handled the interrupt.
+/// @param vector The interrupt vector
+/// @param entry The TSC when the handler was entered
+/// @param exit The TSC when the handler returned
+void irqstat_record(uint32_t vector, uint64_t entry, uint64_t exit);
+
+#endif
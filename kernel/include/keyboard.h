@@ -0,0 +1,44 @@
+/// PS/2 keyboard driver
+///
+/// The keyboard interrupt only pushes events into a lock-free single-producer
+/// single-consumer ring. The single consumer is the keyboard dispatcher
+/// coroutine, which forwards the events to the active tty's keypress callback.
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <input.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief The amount of events the ring can hold. Must be a power of two.
+#define KEY_EVENT_RING_SIZE 128
+
+/// @brief Starts the keyboard dispatcher and unmasks the keyboard interrupt
+void setup_keyboard(void);
+
+/// @brief Handles IRQ1. Must only be called from the keyboard interrupt.
+void keyboard_irq(void);
+
+/// @brief Handles the scancode as if it was received from the keyboard. Used
+///        to replay input reproducibly, e.g. under QEMU.
+/// @param scancode The scancode, with bit 7 set for key releases
+void keyboard_inject(uint8_t scancode);
+
+/// @brief Takes the oldest event out of the ring.
+///
+/// @attention The ring has a single consumer - the keyboard dispatcher.
+///
+/// @returns Whether there was an event to take
+bool keyboard_poll(key_event_t *event);
+
+/// @brief Returns whether the key is currently held down. This is an O(1)
+///        lookup and can be used from any context.
+bool key_is_held(keys_t key);
+
+/// @brief Returns the currently present modifiers (`modifiers_t` flags)
+uint16_t keyboard_modifiers(void);
+
+/// @brief Returns the amount of events dropped because the ring was full
+uint32_t keyboard_overflows(void);
+
+#endif
@@ -0,0 +1,32 @@
+/// Embedded kernel symbol table
+///
+/// The kernel is linked twice: the second link embeds the table of function
+/// addresses and names found in the first one (generated by `tools/ksyms.py`),
+/// so addresses can be printed as `function+offset` without host tools.
+#ifndef KSYM_H
+#define KSYM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief The maximum amount of frames `print_backtrace` prints
+#define BACKTRACE_MAX_DEPTH 16
+
+/// @brief Finds the function that contains the address, in O(log n)
+/// @param offset Set to the address' offset from the function's start
+/// @returns The function's name, or `NULL` if the address isn't in any
+///          function
+const char *ksym_lookup(uintptr_t address, uint32_t *offset);
+
+/// @brief Prints the address as `function+0x1a`, or as a plain hex number if
+///        it's not in any function
+void ksym_print(uintptr_t address);
+
+/// @brief Prints the return addresses found by walking the frame pointers
+///        from `ebp`, one per line
+void print_backtrace(uintptr_t ebp);
+
+/// @brief Returns whether `ebp` can be dereferenced as a stack frame
+bool stack_frame_is_valid(uintptr_t ebp);
+
+#endif
@@ -0,0 +1,95 @@
+/// Kernel metrics
+///
+/// Counters, gauges and log2 histograms that any code can define with
+/// `DEFINE_COUNTER`, `DEFINE_GAUGE` and `DEFINE_HISTOGRAM`. Every metric has a
+/// per-CPU instance, which is only updated by its own CPU with single atomic
+/// read-modify-write instructions, so updates need neither locks nor disabled
+/// interrupts. Reading a metric sums up the instances of all the CPUs.
+///
+/// The metrics' descriptors are placed in the `.metrics` section, which the
+/// linker script collects, so the `stats` command finds all of them without a
+/// registration call.
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <histogram.h>
+#include <percpu.h>
+#include <stdint.h>
+
+typedef enum
+{
+    /// @brief A 64-bit value that only grows, until `stats reset`
+    METRIC_COUNTER,
+    /// @brief A signed value that goes up and down, `stats reset` keeps it
+    METRIC_GAUGE,
+    /// @brief A log2 histogram of 64-bit values
+    METRIC_HISTOGRAM,
+} metric_kind_t;
+
+typedef struct
+{
+    const char *name;
+    metric_kind_t kind;
+    /// @brief The per-CPU instances: `uint64_t`, `int32_t` or `histogram_t`
+    ///        arrays of `MAX_CPUS` elements, depending on the kind
+    void *instances;
+} metric_t;
+
+#define METRIC_DESCRIPTOR(metric_name, metric_kind)                            \
+    static const metric_t __metric_##metric_name                               \
+        __attribute__((section(".metrics"), used, aligned(4))) = {             \
+            .name = #metric_name,                                              \
+            .kind = metric_kind,                                               \
+            .instances = __metric_data_##metric_name,                          \
+    }
+
+/// @brief Defines a counter. Other files can use it after `DECLARE_COUNTER`.
+#define DEFINE_COUNTER(name)                                                   \
+    DEFINE_PER_CPU(uint64_t, __metric_data_##name);                            \
+    METRIC_DESCRIPTOR(name, METRIC_COUNTER)
+
+#define DECLARE_COUNTER(name) DECLARE_PER_CPU(uint64_t, __metric_data_##name)
+
+/// @brief Defines a gauge. Other files can use it after `DECLARE_GAUGE`.
+#define DEFINE_GAUGE(name)                                                     \
+    DEFINE_PER_CPU(int32_t, __metric_data_##name);                             \
+    METRIC_DESCRIPTOR(name, METRIC_GAUGE)
+
+#define DECLARE_GAUGE(name) DECLARE_PER_CPU(int32_t, __metric_data_##name)
+
+/// @brief Defines a histogram. Other files can use it after
+///        `DECLARE_HISTOGRAM`.
+#define DEFINE_HISTOGRAM(name)                                                 \
+    DEFINE_PER_CPU(histogram_t, __metric_data_##name);                         \
+    METRIC_DESCRIPTOR(name, METRIC_HISTOGRAM)
+
+#define DECLARE_HISTOGRAM(name)                                                \
+    DECLARE_PER_CPU(histogram_t, __metric_data_##name)
+
+/// @brief Adds `value` to the counter
+#define counter_add(name, value)                                               \
+    __atomic_add_fetch(&this_cpu(__metric_data_##name), (uint64_t)(value),     \
+                       __ATOMIC_RELAXED)
+
+#define counter_inc(name) counter_add(name, 1)
+
+/// @brief Sets this CPU's share of the gauge. The value read is the sum of all
+///        the CPUs' shares.
+#define gauge_set(name, value)                                                 \
+    __atomic_store_n(&this_cpu(__metric_data_##name), (int32_t)(value),        \
+                     __ATOMIC_RELAXED)
+
+/// @brief Adds `delta`, which may be negative, to the gauge
+#define gauge_add(name, delta)                                                 \
+    __atomic_add_fetch(&this_cpu(__metric_data_##name), (int32_t)(delta),      \
+                       __ATOMIC_RELAXED)
+
+/// @brief Adds `value` to the histogram
+#define histogram_record(name, value)                                          \
+    metric_histogram_add(&this_cpu(__metric_data_##name), (value))
+
+/// @brief Like `histogram_add`, but safe against interrupt handlers that
+///        update the same histogram in-between
+void metric_histogram_add(histogram_t *histogram, uint64_t value);
+
+#endif
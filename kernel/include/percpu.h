@@ -0,0 +1,37 @@
+/// Per-CPU storage
+///
+/// Every per-CPU variable has one instance for each CPU, so each CPU can update
+/// its own instance without any locking, as long as the updates cannot be
+/// interrupted halfway by code on the same CPU touching the same variable.
+#ifndef PERCPU_H
+#define PERCPU_H
+
+/// @brief The maximum amount of CPUs the kernel can use. Only the bootstrap
+///        processor is started for now.
+#define MAX_CPUS 1
+
+// The interrupt entry code in isr.S accesses `irq_stack_top` and
+// `irq_stack_depth` as plain symbols, i.e. the first CPU's instances. It has
+// to index them by the CPU id before another CPU can be started.
+_Static_assert(MAX_CPUS == 1, "isr.S only handles the per-CPU variables of a "
+                              "single CPU");
+
+/// @brief Returns the index of the CPU that executes the caller
+static inline unsigned int cpu_id(void)
+{
+    return 0;
+}
+
+/// @brief Defines a per-CPU variable `name` of the provided type
+#define DEFINE_PER_CPU(type, name) type name[MAX_CPUS]
+
+/// @brief Declares a per-CPU variable defined with `DEFINE_PER_CPU`
+#define DECLARE_PER_CPU(type, name) extern type name[MAX_CPUS]
+
+/// @brief The instance of the per-CPU variable that belongs to the caller's CPU
+#define this_cpu(name) (name[cpu_id()])
+
+/// @brief The instance of the per-CPU variable that belongs to the CPU `cpu`
+#define per_cpu(name, cpu) (name[(cpu)])
+
+#endif
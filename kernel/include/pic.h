@@ -1,6 +1,7 @@
 #ifndef PIC_H
 #define PIC_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /// @brief Sets up the hardware interrupts by remapping
@@ -11,4 +12,16 @@ void setup_pic(void);
 /// @param irq The hardware interrupt number (in range 0 - 16)
 void pic_eoi(uint8_t irq);
 
+/// @brief Allows the PIC to deliver the provided hardware interrupt
+/// @param irq The hardware interrupt number (in range 0 - 16)
+void pic_unmask(uint8_t irq);
+
+/// @brief Checks whether IRQ7 or IRQ15 was raised spuriously, which happens
+///        when the interrupt request disappears before the CPU acknowledges
+///        it. Spurious interrupts must not be acknowledged with `pic_eoi`.
+/// @param irq The hardware interrupt number (in range 0 - 16)
+/// @returns Whether the interrupt was spurious. Always `false` for IRQs other
+///          than 7 and 15.
+bool pic_is_spurious(uint8_t irq);
+
 #endif
\ No newline at end of file
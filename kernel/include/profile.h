@@ -0,0 +1,28 @@
+/// Sampling profiler
+///
+/// While running, the profiler samples the code interrupted by every timer
+/// tick: the interrupted EIP, followed by the return addresses found by
+/// walking the frame pointers. Samples go into a per-CPU ring buffer, which
+/// `profile dump` streams over COM1 in the following binary format, all
+/// integers little-endian:
+///
+/// ```
+/// "PRF1"  u32 cpu  u32 samples  u32 dropped
+/// samples times: u8 depth, depth times u32 address (innermost first)
+/// "PEND"
+/// ```
+///
+/// `tools/profile.py` turns the dump into folded stacks for flame graphs.
+/// `profile top` lists the hottest functions right away, using the embedded
+/// symbol table.
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/// @brief The maximum amount of addresses in a sample
+#define PROFILE_MAX_DEPTH 16
+
+/// @brief The size of each CPU's ring buffer in 32-bit words. Must be a power
+///        of two. A sample takes `1 + depth` words.
+#define PROFILE_RING_WORDS 32768
+
+#endif
@@ -0,0 +1,21 @@
+/// QEMU's `isa-debug-exit` device
+///
+/// When QEMU runs with `-device isa-debug-exit,iobase=0xf4,iosize=0x04`, a
+/// write to the port ends QEMU with the exit status `(code << 1) | 1`, which
+/// lets scripts such as `make perf` learn how the kernel finished. Without the
+/// device the write has no effect.
+#ifndef QEMU_H
+#define QEMU_H
+
+#include <stdint.h>
+
+#define QEMU_DEBUG_EXIT_PORT 0xf4
+
+/// @brief The code the kernel exits with after a kernel panic
+#define QEMU_EXIT_PANIC 0x7f
+
+/// @brief Ends QEMU with the exit code. Returns when the kernel doesn't run
+///        under QEMU with the `isa-debug-exit` device.
+void qemu_exit(uint8_t code);
+
+#endif
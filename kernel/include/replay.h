@@ -0,0 +1,32 @@
+/// Keyboard input record and replay
+///
+/// While recording, every scancode received from the keyboard is logged with
+/// the timer tick it arrived at, relative to the start of the recording, and
+/// so are the seeds the games pass to `srand`. Replaying injects the same
+/// scancodes through the keyboard path at the same ticks, and hands out the
+/// same seeds, so a tetris or pong session - starting the game included - can
+/// be repeated on another build and its frame-time metrics compared.
+///
+/// `replay dump` writes the recording to the serial line as `replay seed` and
+/// `replay event` commands, which load it again when they are sent back to
+/// the serial console.
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+
+/// @brief The maximum amount of recorded scancodes
+#define REPLAY_MAX_EVENTS 4096
+
+/// @brief The maximum amount of recorded seeds
+#define REPLAY_MAX_SEEDS 16
+
+/// @brief Logs the scancode if a recording is running. Called by the keyboard
+///        interrupt for every received scancode.
+void replay_record_scancode(uint8_t scancode);
+
+/// @brief Returns a seed for `srand`: a fresh one, which is logged while
+///        recording, or the next logged one while replaying
+uint32_t replay_seed(void);
+
+#endif
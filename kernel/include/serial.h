@@ -1,9 +1,20 @@
 #ifndef SERIAL_H
 #define SERIAL_H
 
+#include <stdbool.h>
+
 int init_serial();
 
 void write_serial(char a);
 char read_serial();
 
+/// @brief Reads a received character without blocking
+/// @param c Where to store the received character
+/// @returns Whether a character was received
+bool serial_try_read(char *c);
+
+/// @brief Like `printf`, but only writes to the serial line. Used for output
+///        meant to be read by host-side tools rather than by the user.
+int serial_printf(const char *format, ...);
+
 #endif
\ No newline at end of file
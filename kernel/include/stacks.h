@@ -0,0 +1,32 @@
+/// Kernel stacks and their usage tracking
+#ifndef STACKS_H
+#define STACKS_H
+
+#include <percpu.h>
+#include <stdint.h>
+
+/// @brief Size of the per-CPU stack that interrupt handlers run on
+#define IRQ_STACK_SIZE 8192
+
+/// @brief Size of the stacks of the double fault and NMI tasks
+#define FAULT_STACK_SIZE 4096
+
+/// @brief The top of each CPU's interrupt stack. Loaded by the ISR stubs.
+DECLARE_PER_CPU(uint8_t *, irq_stack_top);
+
+/// @brief How deeply nested the interrupt handlers running on each CPU are.
+///        The ISR stubs only switch to the interrupt stack when it's zero.
+DECLARE_PER_CPU(uint32_t, irq_stack_depth);
+
+/// @brief Returns the top of the double fault task's stack
+uint8_t *double_fault_stack_top(void);
+
+/// @brief Returns the top of the NMI task's stack
+uint8_t *nmi_stack_top(void);
+
+/// @brief Fills all the kernel stacks with a known pattern, so that their
+///        high-water marks can be found later. Must be called early, on the
+///        boot stack, before interrupts are enabled.
+void setup_stacks(void);
+
+#endif
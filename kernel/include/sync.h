@@ -0,0 +1,153 @@
+/// Synchronization primitives
+///
+/// Every lock belongs to a lock class. When the kernel is built with
+/// `LOCKSTAT`, each class records how often its locks were acquired, how often
+/// an acquisition had to spin, and the longest time a lock was held. The
+/// `lockstat` command prints those statistics.
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <hal.h>
+#include <irqsoff.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief The saved state of the interrupt flag
+typedef uint32_t irq_flags_t;
+
+/// @brief Disables interrupts and returns whether they were enabled before.
+///
+/// Unlike a bare `cli` and `sti`, `irq_save` and `irq_restore` nest:
+/// interrupts are only enabled again by the `irq_restore` matching the
+/// outermost `irq_save` that disabled them.
+///
+/// @param caller The address reported by the interrupts-off tracer
+static inline irq_flags_t irq_save_from(uintptr_t caller)
+{
+    irq_flags_t flags = hal_save_flags_cli();
+
+    if (flags & EFLAGS_IF)
+    {
+        irqsoff_begin(caller);
+    }
+
+    return flags;
+}
+
+/// @brief Like `irq_save_from`, reporting the caller to the tracer
+#define irq_save() irq_save_from(THIS_IP)
+
+/// @brief Enables interrupts if they were enabled when `flags` were saved
+static inline void irq_restore(irq_flags_t flags)
+{
+    if (flags & EFLAGS_IF)
+    {
+        irqsoff_end();
+        hal_sti();
+    }
+}
+
+/// @brief Tells the CPU that we're in a spin-wait loop
+static inline void cpu_relax(void)
+{
+    __asm__ volatile("pause" : : : "memory");
+}
+
+/// @brief Contention statistics shared by all the locks of one kind
+typedef struct lock_class
+{
+    const char *name;
+    uint32_t acquisitions;
+    /// @brief Acquisitions that found the lock taken and had to spin
+    uint32_t contentions;
+    /// @brief Total amount of spin loop iterations
+    uint32_t spins;
+    /// @brief The longest time (in TSC cycles) any lock was held
+    uint32_t max_hold_cycles;
+
+    bool registered;
+    struct lock_class *next;
+} lock_class_t;
+
+/// @brief Defines a lock class called `class_name`
+#define DEFINE_LOCK_CLASS(var, class_name) lock_class_t var = {.name = class_name}
+
+/// @brief A fair ticket spinlock
+typedef struct
+{
+    volatile uint16_t next_ticket;
+    volatile uint16_t owner;
+    lock_class_t *class;
+    uint64_t acquired_at;
+} spinlock_t;
+
+#define SPINLOCK_INIT(lock_class) {.class = (lock_class)}
+
+void spin_lock(spinlock_t *lock);
+bool spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+
+/// @brief Disables interrupts and takes the lock. Needed for locks that are
+///        also taken by interrupt handlers.
+irq_flags_t spin_lock_irqsave(spinlock_t *lock);
+void spin_unlock_irqrestore(spinlock_t *lock, irq_flags_t flags);
+
+/// @brief A reader-writer spinlock. Any amount of readers, or a single writer
+///        may hold it at once.
+typedef struct
+{
+    /// @brief The amount of readers, or `-1` when taken by a writer
+    volatile int32_t count;
+    lock_class_t *class;
+    uint64_t acquired_at;
+} rwlock_t;
+
+#define RWLOCK_INIT(lock_class) {.class = (lock_class)}
+
+void read_lock(rwlock_t *lock);
+void read_unlock(rwlock_t *lock);
+void write_lock(rwlock_t *lock);
+void write_unlock(rwlock_t *lock);
+
+/// @brief A sequence lock for small, read-mostly data.
+///
+/// Writers never wait for readers. Readers don't write to the lock at all and
+/// retry instead if a write happened while they were reading:
+///
+/// ```
+/// uint32_t seq;
+/// do
+/// {
+///     seq = read_seqbegin(&lock);
+///     value = shared_value;
+/// } while (read_seqretry(&lock, seq));
+/// ```
+typedef struct
+{
+    /// @brief Odd while a write is in progress
+    volatile uint32_t sequence;
+    spinlock_t writer;
+} seqlock_t;
+
+#define SEQLOCK_INIT(lock_class) {.writer = SPINLOCK_INIT(lock_class)}
+
+void write_seqlock(seqlock_t *lock);
+void write_sequnlock(seqlock_t *lock);
+
+static inline uint32_t read_seqbegin(seqlock_t *lock)
+{
+    uint32_t sequence;
+
+    while ((sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE)) & 1)
+    {
+        cpu_relax();
+    }
+
+    return sequence;
+}
+
+/// @brief Returns whether the data read since `read_seqbegin` returned
+///        `start` may be inconsistent and has to be read again
+bool read_seqretry(seqlock_t *lock, uint32_t start);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+/// @brief The frequency at which the PIT raises IRQ0
+#define TIMER_HZ 1000
+
+/// @brief Programs the PIT to fire IRQ0 `TIMER_HZ` times a second and unmasks
+///        the timer interrupt.
+void setup_timer(void);
+
+/// @brief Called from the IRQ0 handler on every timer tick
+void timer_tick(void);
+
+/// @brief Returns the amount of timer ticks since `setup_timer`
+uint64_t timer_ticks(void);
+
+/// @brief Returns the TSC frequency in kHz, i.e. TSC cycles per millisecond.
+///        The first call measures it against the PIT, which takes a few
+///        ticks and needs interrupts to be enabled.
+uint32_t timer_tsc_khz(void);
+
+#endif
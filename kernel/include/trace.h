@@ -0,0 +1,124 @@
+/// Static tracepoints
+///
+/// `TRACE(name, arg)` records an event with a TSC timestamp and a 32-bit
+/// argument into the CPU's trace ring. While a tracepoint is disabled, its
+/// sites are a single 5-byte NOP: enabling it patches every site into a jump
+/// to the code that records the event. The sites are found in the
+/// `__jump_table` section, which the linker script collects.
+///
+/// The `trace` command enables tracepoints by name and drains the ring over
+/// the serial line, `tools/trace2json.py` converts the dump to the Chrome trace
+/// format.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+    TRACE_INSTANT,
+    /// @brief Starts a span. Its name ends with `_entry`.
+    TRACE_BEGIN,
+    /// @brief Ends the span started by the matching `_entry` tracepoint. Its
+    ///        name ends with `_exit`.
+    TRACE_END,
+} trace_kind_t;
+
+// clang-format off
+
+/// All the tracepoints, as `X(name, kind)`
+#define TRACEPOINT_LIST(X)                                                     \
+    X(irq_entry,       TRACE_BEGIN)   /* vector */                             \
+    X(irq_exit,        TRACE_END)     /* vector */                             \
+    X(key_event,       TRACE_INSTANT) /* key, bit 8 set when pressed */        \
+    X(command_entry,   TRACE_BEGIN)   /* command index */                      \
+    X(command_exit,    TRACE_END)     /* command index */                      \
+    X(tty_flush_entry, TRACE_BEGIN)   /* bytes copied to VGA memory */         \
+    X(tty_flush_exit,  TRACE_END)     /* 0 */                                  \
+    X(tty_move_up,     TRACE_INSTANT) /* 0 */                                  \
+    X(tetris_step,     TRACE_INSTANT) /* 0 */                                  \
+    X(game_frame,      TRACE_INSTANT) /* cycles since the previous frame */
+
+// clang-format on
+
+#define TRACEPOINT_ID(name, kind) TRACE_ID_##name,
+
+typedef enum
+{
+    TRACEPOINT_LIST(TRACEPOINT_ID)
+    TRACEPOINT_COUNT,
+} tracepoint_id_t;
+
+#undef TRACEPOINT_ID
+
+typedef struct
+{
+    const char *name;
+    uint16_t id;
+    uint8_t kind;
+    bool enabled;
+} tracepoint_t;
+
+#define TRACEPOINT_DECLARE(name, kind) extern tracepoint_t __tracepoint_##name;
+
+TRACEPOINT_LIST(TRACEPOINT_DECLARE)
+
+#undef TRACEPOINT_DECLARE
+
+/// @brief A record in the trace ring, as dumped over the serial line
+typedef struct
+{
+    uint64_t timestamp;
+    uint32_t arg;
+    uint16_t id;
+    uint16_t cpu;
+} trace_record_t;
+
+/// @brief Returns whether the tracepoint is enabled. Compiles to a NOP that
+///        `tracepoint_set` patches into a jump to the `true` branch.
+static inline __attribute__((always_inline)) bool
+tracepoint_enabled(tracepoint_t *tracepoint)
+{
+    __asm__ goto("1: .byte 0x0f, 0x1f, 0x44, 0x00, 0x00\n\t"
+                 ".pushsection __jump_table, \"aw\"\n\t"
+                 ".balign 4\n\t"
+                 ".long 1b, %l[enabled], %c0\n\t"
+                 ".popsection"
+                 :
+                 : "i"(tracepoint)
+                 :
+                 : enabled);
+
+    return false;
+
+enabled:
+    return true;
+}
+
+/// @brief Writes a record to this CPU's trace ring
+void trace_record(tracepoint_t *tracepoint, uint32_t arg);
+
+/// @brief Enables or disables all the sites of the tracepoint
+void tracepoint_set(tracepoint_t *tracepoint, bool enabled);
+
+#ifdef HOST_BUILD
+
+// a host program can't patch its read-only code, and has `perf` instead
+#define TRACE(name, arg) ((void)(arg))
+
+#else
+
+/// @brief Records the event if the tracepoint `name` is enabled
+#define TRACE(name, arg)                                                       \
+    do                                                                         \
+    {                                                                          \
+        if (tracepoint_enabled(&__tracepoint_##name))                          \
+        {                                                                      \
+            trace_record(&__tracepoint_##name, (arg));                         \
+        }                                                                      \
+    } while (0)
+
+#endif
+
+#endif
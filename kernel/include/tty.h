@@ -13,6 +13,18 @@
 #define TTY_HEIGHT (VGA_HEIGHT - 1)
 #define SCRATCHPAD_WIDTH 78
 
+/// The 32 KiB of VGA text memory hold `VGA_PAGES` screens, each starting at a
+/// multiple of `VGA_PAGE_CELLS` cells. The CRTC start address selects the
+/// page that's shown.
+#define VGA_PAGES 8
+#define VGA_PAGE_CELLS 2048
+
+/// @brief The page that shows the ttys that didn't get a page of their own
+#define TTY_SHARED_PAGE (VGA_PAGES - 1)
+
+/// @brief The amount of ttys that Alt+F1 to Alt+F8 switch between
+#define TTY_SWITCH_KEYS 8
+
 typedef enum
 {
     TTY_COLOR_BLACK = 0,
@@ -47,28 +59,107 @@ typedef struct
     terminal_entry_color_t color;
 } terminal_entry_t;
 
-/// @brief Callback called on a keypress.
-typedef void (*keypress_callback_t)(keys_t key, bool was_pressed, void *data);
+/// @brief Packs the entry into the format of the VGA text buffer
+static inline uint16_t vga_entry_pack(terminal_entry_t terminal_entry)
+{
+    return (uint16_t)(terminal_entry.character) |
+           (uint16_t)(terminal_entry.color.background) << 12 |
+           (uint16_t)(terminal_entry.color.foreground) << 8;
+}
+
+/// @brief The most parameters of a control sequence that are kept, the
+///        following ones are ignored
+#define TTY_ESCAPE_PARAMS 8
+
+/// @brief The largest value of a control sequence parameter
+#define TTY_ESCAPE_PARAM_MAX 9999
+
+typedef enum
+{
+    /// @brief Not in an escape sequence
+    TTY_ESCAPE_NONE,
+    /// @brief After an ESC
+    TTY_ESCAPE_START,
+    /// @brief After an ESC [, in the parameters of a control sequence
+    TTY_ESCAPE_CSI,
+} tty_escape_state_t;
+
+/// @brief An escape sequence that `tty_write` has seen part of. Sequences can
+///        be split between writes, e.g. `putchar` writes a byte at a time.
+typedef struct
+{
+    tty_escape_state_t state;
+    /// @brief Whether the parameters started with `?`, e.g. ESC [ ? 25 l
+    bool private_marker;
+    /// @brief The amount of parameters seen so far, may exceed
+    ///        `TTY_ESCAPE_PARAMS`
+    uint32_t count;
+    uint16_t params[TTY_ESCAPE_PARAMS];
+} tty_escape_t;
+
+/// @brief Two adjacent cells of a buffer in the VGA format, which code that
+///        copies or compares whole rows reads and writes at once. May alias
+///        the `uint16_t` cells.
+typedef uint32_t __attribute__((may_alias)) vga_cell_pair_t;
+
+/// @brief Callback called on every key press and release while the tty is
+///        active.
+typedef void (*keypress_callback_t)(const key_event_t *event, void *data);
 
 /// @brief A virtual terminal buffer.
 ///
-/// All terminal operations will operate on virtual terminal buffers.
-/// The terminal buffer will only flush on a call to `tty_flush`.
+/// The first ttys to be initialized get a VGA page of their own, which their
+/// writes go straight to, so activating them only switches the shown page.
+/// The others write to their `shadow` buffer, which `tty_flush` copies to the
+/// shared page while they're active.
 typedef struct
 {
-    uint16_t buffer[BUFFER_SIZE];
+    /// @brief The tty's VGA page, or its `shadow`. Set by `tty_initialize`.
+    uint16_t *buffer;
+    uint16_t shadow[BUFFER_SIZE];
+    /// @brief The VGA page the tty is shown on
+    uint32_t page;
     size_t cursor_row;
     size_t cursor_col;
     bool cursor_visible;
     terminal_entry_color_t color;
+    /// @brief The color set by `tty_clear`, which SGR 0 goes back to
+    terminal_entry_color_t default_color;
+    /// @brief Whether SGR 1 is on, which brightens the 30-37 foregrounds set
+    ///        after it as well
+    bool bold;
+
+    /// @brief The rows that scroll when a line feed leaves the last one, from
+    ///        `scroll_top` up to, but not including, `scroll_bottom`
+    size_t scroll_top;
+    size_t scroll_bottom;
+    /// @brief The cursor position saved by ESC 7 or CSI s
+    size_t saved_row;
+    size_t saved_col;
+    tty_escape_t escape;
+
     keypress_callback_t on_keypress;
     void *keypress_callback_data;
+
+    /// @brief Whether the buffer shows the effect of a key event that wasn't
+    ///        flushed yet, see `tty_mark_input`
+    bool input_pending;
+    uint32_t input_event_id;
+    uint64_t input_timestamp;
 } tty_t;
 
-/// @brief Initializes the terminal for usage
+/// @brief Initializes the terminal for usage. The first initialization gives
+///        the tty its buffer, and its place among the ttys that Alt+F1 to
+///        Alt+F8 switch between.
 void tty_initialize(tty_t *tty);
 
-/// @brief Clears the terminal, resets the cursor position and color.
+/// @brief Initializes a tty that always writes to its shadow buffer and isn't
+///        among the ttys that Alt+F1 to Alt+F8 switch between, e.g. a scratch
+///        tty for the benchmarks
+void tty_initialize_shadow(tty_t *tty);
+
+/// @brief Clears the terminal, resets the cursor position and color, the scroll
+///        region and the escape sequence parser.
 void tty_clear(tty_t *tty, terminal_color_t background);
 
 /// @brief Sets the callback that's called on every key press/release
@@ -100,10 +191,11 @@ void tty_set_char_at(tty_t *tty, char c, size_t x, size_t y);
 /// @brief Moves the terminal cursor to the next character's position
 void tty_next_char(tty_t *tty);
 
-/// @brief Moves the terminal cursor to a new line
+/// @brief Moves the terminal cursor to a new line, scrolling if it leaves the
+///        scroll region's last row
 void tty_next_line(tty_t *tty);
 
-/// @brief Scrolls the terminal up by one line
+/// @brief Scrolls the scroll region up by one line
 void tty_move_up(tty_t *tty);
 
 /// @brief Inserts the provided entry at the cursor position
@@ -112,7 +204,31 @@ void tty_move_up(tty_t *tty);
 void tty_put_entry(tty_t *tty, terminal_entry_t entry);
 
 /// @brief Writes the provided `data` with the provided `size` to the terminal
-///        at the cursor's position with the `color`
+///        at the cursor's position with the `color`. The characters between
+///        control characters are stored a line at a time, with the color
+///        packed once.
+///
+/// `\n` moves to the next line and `\r` to the start of the line. The ANSI
+/// escape sequences below are handled, others are dropped. `n` and `m` are
+/// decimal parameters, 1 when omitted, positions count from 1 and stay on the
+/// screen above the scratchpad.
+///
+/// - ESC [ n A, B, C, D: moves the cursor up, down, right, left
+/// - ESC [ n E, F: moves the cursor to the start of the n-th next, previous
+///   line
+/// - ESC [ n G, d: moves the cursor to the column, row
+/// - ESC [ n ; m H or f: moves the cursor to row n, column m
+/// - ESC [ n J: erases from the cursor to the end of the screen (n = 0), from
+///   its start to the cursor (1), or the whole screen (2). Defaults to 0.
+/// - ESC [ n K: the same for the cursor's line
+/// - ESC [ ... m: SGR, sets the colors. 0 resets them, 1 and 22 turn the bright
+///   foreground on and off, also for the 30-37 ones that follow. 30-37 and
+///   90-97 set the foreground, 40-47 and 100-107 the background, 39 and 49
+///   reset either.
+/// - ESC [ n ; m r: scrolls only rows n to m, the whole screen when omitted
+/// - ESC [ s, ESC [ u, ESC 7, ESC 8: saves, restores the cursor position
+/// - ESC [ ? 25 h, l: shows, hides the cursor
+/// - ESC c: clears the screen and resets the tty
 ///
 /// @param data Data to write to terminal
 /// @param size Size of the data to write
@@ -132,11 +248,26 @@ void tty_write_string(tty_t *tty, const char *data);
 void tty_set_color(tty_t *tty, terminal_entry_color_t color);
 
 /// @brief If the provided tty is active, it will be flushed to the tty buffer.
-/// Otherwise, this function has no effect.
+/// Otherwise, this function has no effect. Only the cursor has to be updated
+/// for ttys with a VGA page of their own.
 void tty_flush(tty_t *tty);
 
+/// @brief Tells the tty that the buffer now shows the effect of the key event.
+///        The next `tty_flush` measures the keypress-to-screen latency of the
+///        oldest such event.
+void tty_mark_input(tty_t *tty, const key_event_t *event);
+
 void set_active_tty(tty_t *tty);
 
+/// @brief Releases the VGA lock whoever holds it, so a panic can still write
+///        to the screen. Called with interrupts disabled, the kernel doesn't
+///        go on afterwards.
+void tty_panic_takeover(void);
+
+/// @brief Activates the `index`th initialized tty, if there is one
+/// @returns Whether the tty exists
+bool tty_switch(uint32_t index);
+
 tty_t *get_active_tty();
 
 /// @brief The kernel tty.
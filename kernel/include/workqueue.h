@@ -0,0 +1,35 @@
+/// Deferred work (bottom halves)
+///
+/// Interrupt handlers should only do the minimum amount of work needed to
+/// acknowledge the device, and queue the rest with `work_queue`. Queued work is
+/// executed later by the worker coroutine, outside of interrupt context and with
+/// interrupts enabled.
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief The amount of work items that can be queued on a single CPU. Must be
+///        a power of two.
+#define WORKQUEUE_SIZE 64
+
+/// @brief The function executing a deferred work item
+typedef void (*work_fn_t)(uint32_t arg, void *data);
+
+/// @brief Queues the work item on the current CPU.
+///
+/// This is lock-free and safe to call from interrupt handlers, including ones
+/// that interrupted another `work_queue` call.
+///
+/// @returns Whether the work was queued. Fails if the queue is full.
+bool work_queue(work_fn_t fn, uint32_t arg, void *data);
+
+/// @brief Returns the amount of executed work items and the amount of work
+///        items that were dropped because the queue was full
+void workqueue_get_stats(uint32_t *executed, uint32_t *overflows);
+
+/// @brief Starts the worker coroutine that executes the queued work
+void setup_workqueue(void);
+
+#endif
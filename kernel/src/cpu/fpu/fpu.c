@@ -0,0 +1,285 @@
+#include <bench.h>
+#include <cpuid.h>
+#include <fpu.h>
+#include <metrics.h>
+#include <panic.h>
+#include <percpu.h>
+#include <stacks.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sync.h>
+
+/// CR0: `wait` and `fwait` respect TS as well
+#define CR0_MP (1 << 1)
+/// CR0: the FPU is emulated, every FPU instruction raises #NM
+#define CR0_EM (1 << 2)
+/// CR0: task switched, the next FPU or SSE instruction raises #NM
+#define CR0_TS (1 << 3)
+/// CR0: x87 errors raise #MF instead of going through the PIC
+#define CR0_NE (1 << 5)
+
+/// CR4: the kernel uses `fxsave` and `fxrstor`, enables SSE
+#define CR4_OSFXSR (1 << 9)
+/// CR4: unmasked SSE errors raise #XM instead of #UD
+#define CR4_OSXMMEXCPT (1 << 10)
+
+static fpu_context_t fpu_contexts[FPU_CONTEXTS];
+
+/// @brief The state right after `fninit`, which every context starts from
+static fpu_state_t fpu_initial_state;
+
+static bool fpu_has_fxsr;
+
+/// @brief The context of the code running outside of any coroutine
+static fpu_context_t *fpu_kernel_context;
+
+/// @brief The context whose state is in the FPU registers, or `NULL`
+static DEFINE_PER_CPU(fpu_context_t *, fpu_owner);
+
+/// @brief Where the running context's pointer is stored
+static DEFINE_PER_CPU(fpu_context_t **, fpu_current);
+
+/// @brief Whether TS was set by us. Hardware task switches, i.e. the NMI and
+///        double fault tasks, set TS behind our back, which only costs an
+///        extra #NM.
+static DEFINE_PER_CPU(bool, fpu_ts);
+
+static DEFINE_PER_CPU(bool, fpu_in_kernel);
+static DEFINE_PER_CPU(irq_flags_t, fpu_kernel_flags);
+
+DEFINE_COUNTER(fpu_traps);
+DEFINE_COUNTER(fpu_saves);
+DEFINE_GAUGE(fpu_contexts_used);
+
+static inline uint32_t read_cr0(void)
+{
+    uint32_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    return cr0;
+}
+
+static inline void write_cr0(uint32_t cr0)
+{
+    __asm__ volatile("mov %0, %%cr0" ::"r"(cr0) : "memory");
+}
+
+static inline uint32_t read_cr4(void)
+{
+    uint32_t cr4;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+    return cr4;
+}
+
+static inline void write_cr4(uint32_t cr4)
+{
+    __asm__ volatile("mov %0, %%cr4" ::"r"(cr4) : "memory");
+}
+
+static inline void fpu_clear_ts(void)
+{
+    __asm__ volatile("clts" ::: "memory");
+    this_cpu(fpu_ts) = false;
+}
+
+static inline void fpu_set_ts(void)
+{
+    write_cr0(read_cr0() | CR0_TS);
+    this_cpu(fpu_ts) = true;
+}
+
+static inline void fpu_save(fpu_state_t *state)
+{
+    // `fnsave` also reinitializes the FPU, which doesn't matter here
+    if (fpu_has_fxsr)
+    {
+        __asm__ volatile("fxsave %0" : "=m"(*state));
+    }
+    else
+    {
+        __asm__ volatile("fnsave %0" : "=m"(*state));
+    }
+}
+
+static inline void fpu_restore(const fpu_state_t *state)
+{
+    if (fpu_has_fxsr)
+    {
+        __asm__ volatile("fxrstor %0" ::"m"(*state));
+    }
+    else
+    {
+        __asm__ volatile("frstor %0" ::"m"(*state));
+    }
+}
+
+void setup_fpu(void)
+{
+    uint32_t features = cpuid(CPUID_FEATURES).edx;
+
+    fpu_has_fxsr = (features & CPUID_EDX_FXSR) != 0;
+
+    write_cr0((read_cr0() & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+
+    if (fpu_has_fxsr)
+    {
+        uint32_t cr4 = read_cr4() | CR4_OSFXSR;
+
+        if (features & CPUID_EDX_SSE)
+        {
+            cr4 |= CR4_OSXMMEXCPT;
+        }
+
+        write_cr4(cr4);
+    }
+
+    __asm__ volatile("fninit");
+    fpu_save(&fpu_initial_state);
+
+    this_cpu(fpu_owner) = NULL;
+    this_cpu(fpu_current) = &fpu_kernel_context;
+    fpu_set_ts();
+}
+
+void fpu_switch(fpu_context_t **context)
+{
+    if (!context)
+    {
+        context = &fpu_kernel_context;
+    }
+
+    this_cpu(fpu_current) = context;
+
+    // a context that doesn't own the registers traps on its first use, so
+    // TS only has to be cleared when switching back to the owner
+    bool owns = *context && *context == this_cpu(fpu_owner);
+
+    if (owns && this_cpu(fpu_ts))
+    {
+        fpu_clear_ts();
+    }
+    else if (!owns && !this_cpu(fpu_ts))
+    {
+        fpu_set_ts();
+    }
+}
+
+static fpu_context_t *fpu_context_alloc(void)
+{
+    for (int i = 0; i < FPU_CONTEXTS; i++)
+    {
+        if (!fpu_contexts[i].in_use)
+        {
+            fpu_contexts[i].in_use = true;
+            gauge_add(fpu_contexts_used, 1);
+
+            return &fpu_contexts[i];
+        }
+    }
+
+    kpanic("More than %d contexts use the FPU\n", FPU_CONTEXTS);
+}
+
+void fpu_release(fpu_context_t **context)
+{
+    fpu_context_t *released = *context;
+
+    if (!released)
+    {
+        return;
+    }
+
+    *context = NULL;
+
+    if (this_cpu(fpu_owner) == released)
+    {
+        this_cpu(fpu_owner) = NULL;
+    }
+
+    released->in_use = false;
+    gauge_add(fpu_contexts_used, -1);
+}
+
+void fpu_device_not_available(void)
+{
+    // the #NM itself is one level, whatever it interrupted is another one
+    if (this_cpu(irq_stack_depth) > 1)
+    {
+        kpanic("An interrupt handler used the FPU without kernel_fpu_begin\n");
+    }
+
+    fpu_clear_ts();
+    counter_inc(fpu_traps);
+
+    fpu_context_t **current = this_cpu(fpu_current);
+    fpu_context_t *owner = this_cpu(fpu_owner);
+
+    // TS was set by a hardware task switch
+    if (*current && *current == owner)
+    {
+        return;
+    }
+
+    if (owner)
+    {
+        fpu_save(&owner->state);
+        counter_inc(fpu_saves);
+    }
+
+    if (!*current)
+    {
+        *current = fpu_context_alloc();
+        (*current)->state = fpu_initial_state;
+    }
+
+    fpu_restore(&(*current)->state);
+    this_cpu(fpu_owner) = *current;
+}
+
+void kernel_fpu_begin(void)
+{
+    irq_flags_t flags = irq_save();
+
+    if (this_cpu(fpu_in_kernel))
+    {
+        kpanic("kernel_fpu_begin nested\n");
+    }
+
+    this_cpu(fpu_in_kernel) = true;
+    this_cpu(fpu_kernel_flags) = flags;
+
+    __asm__ volatile("clts" ::: "memory");
+
+    if (this_cpu(fpu_owner))
+    {
+        fpu_save(&this_cpu(fpu_owner)->state);
+        counter_inc(fpu_saves);
+    }
+
+    fpu_restore(&fpu_initial_state);
+}
+
+void kernel_fpu_end(void)
+{
+    // the owner keeps the registers, so nothing traps after the section
+    if (this_cpu(fpu_owner))
+    {
+        fpu_restore(&this_cpu(fpu_owner)->state);
+    }
+
+    if (this_cpu(fpu_ts))
+    {
+        write_cr0(read_cr0() | CR0_TS);
+    }
+
+    this_cpu(fpu_in_kernel) = false;
+    irq_restore(this_cpu(fpu_kernel_flags));
+}
+
+static void bench_kernel_fpu(void)
+{
+    kernel_fpu_begin();
+    kernel_fpu_end();
+}
+
+DEFINE_BENCH(kernel_fpu, .run = bench_kernel_fpu);
@@ -1,3 +1,4 @@
+#include <gdt.h>
 #include <panic.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -51,6 +52,12 @@
 #define SEG_CODE_XR_C      0b1110 // |      ✓      |     ✓     |     x     |
 #define SEG_CODE_XR_C_A    0b1111 // |      ✓      |     ✓     |     ✓     |
 
+// System segment types (descriptor type `0`).
+// Look at intel manual table 3-2
+
+#define SEG_TSS32_AVAILABLE 0b1001
+#define SEG_TSS32_BUSY      0b1011
+
 // END OF ACCESS BYTES
 // -------------------------------------------------------
 
@@ -80,7 +87,7 @@
 // clang-format on
 //
 
-#define SEGMENT_COUNT 4
+#define SEGMENT_COUNT (4 + TSS_COUNT)
 
 static uint8_t gdt_table[(SEGMENT_COUNT + 1) * 8];
 
@@ -195,5 +202,18 @@ void setup_gdt(void)
         data_user,
     };
 
+    for (int i = 0; i < TSS_COUNT; i++)
+    {
+        gdt_segment_descriptor_t tss = {
+            .base = tss_base(i),
+            .limit = tss_limit(),
+            .access = SEG_PRESENT | SEG_PRIVILEGE(0) | SEG_TYPE(0) |
+                      SEG_TSS32_AVAILABLE,
+            .flags = 0,
+        };
+
+        segments[4 + i] = tss;
+    }
+
     write_gdts(segments);
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include <gdt.h>
+#include <idt.h>
+#include <ksym.h>
+#include <panic.h>
+#include <stacks.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <workqueue.h>
+
+/// @brief A 32-bit task state segment. See intel manual figure 8-2
+typedef struct
+{
+    uint32_t prev_task_link;
+    uint32_t esp0, ss0;
+    uint32_t esp1, ss1;
+    uint32_t esp2, ss2;
+    uint32_t cr3;
+    uint32_t eip, eflags;
+    uint32_t eax, ecx, edx, ebx;
+    uint32_t esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs;
+    uint32_t ldt;
+    uint16_t trap;
+    uint16_t iomap_base;
+} __attribute__((packed)) tss_t;
+
+/// Bit 1 of EFLAGS is reserved and always set. The tasks start with
+/// interrupts disabled.
+#define TASK_EFLAGS 0x2
+
+__attribute__((aligned(16))) static tss_t tss[TSS_COUNT];
+
+static volatile uint32_t nmi_count;
+
+// defined in `isr.S`
+extern void double_fault_task_entry(void);
+extern void nmi_task_entry(void);
+
+uint32_t tss_base(int index)
+{
+    return (uint32_t)&tss[index];
+}
+
+uint32_t tss_limit(void)
+{
+    return sizeof(tss_t) - 1;
+}
+
+static void init_task(tss_t *task, void (*entry)(void), uint8_t *stack_top,
+                      uint32_t cr3)
+{
+    task->cr3 = cr3;
+    task->eip = (uint32_t)entry;
+    task->eflags = TASK_EFLAGS;
+    task->esp = (uint32_t)stack_top;
+    task->cs = KERNEL_CS;
+    task->ss = task->ds = task->es = task->fs = task->gs = KERNEL_DS;
+    // the I/O permission bitmap starts past the limit, so there is none
+    task->iomap_base = sizeof(tss_t);
+}
+
+/// @brief Runs in the double fault task. The state of the task that faulted
+///        was saved by the CPU in the kernel's TSS.
+void double_fault_handler(uint32_t err_code)
+{
+    tss_t *kernel = &tss[TSS_INDEX_KERNEL];
+
+    start_kpanic();
+
+    printf("Exception interrupt received:\n");
+    printf("-> [0x08] Double Fault\n\nCPU state:\n");
+    printf("eip: ");
+    ksym_print(kernel->eip);
+    printf("\nerr_code: 0x%x  eflags: 0x%x\n", err_code, kernel->eflags);
+    printf("esp: 0x%x  ebp: 0x%x\n", kernel->esp, kernel->ebp);
+
+    print_backtrace(kernel->ebp);
+
+    end_kpanic();
+}
+
+static void report_nmi(uint32_t count, void *data)
+{
+    (void)data;
+
+    printf("Non-maskable interrupt received (%d so far)\n", count);
+}
+
+/// @brief Runs in the NMI task every time an NMI is received
+void nmi_handler(void)
+{
+    // printing right away could deadlock, the NMI might have interrupted
+    // someone holding a lock
+    work_queue(report_nmi, ++nmi_count, NULL);
+}
+
+void setup_tss(void)
+{
+    uint32_t cr3;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(cr3));
+
+    tss[TSS_INDEX_KERNEL].iomap_base = sizeof(tss_t);
+
+    init_task(&tss[TSS_INDEX_DOUBLE_FAULT], double_fault_task_entry,
+              double_fault_stack_top(), cr3);
+    init_task(&tss[TSS_INDEX_NMI], nmi_task_entry, nmi_stack_top(), cr3);
+
+    // the CPU saves the state of the running task here on a task switch
+    __asm__ volatile("ltr %w0" : : "r"((uint16_t)TSS_KERNEL));
+
+    idt_set_task_gate(2, TSS_NMI);
+    idt_set_task_gate(8, TSS_DOUBLE_FAULT);
+}
@@ -1,6 +1,8 @@
 #include <gdt.h>
+#include <irqsoff.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <sync.h>
 
 typedef struct
 {
@@ -41,18 +43,27 @@ void idt_set_descriptor(uint8_t vector, void *isr, uint8_t flags)
     descriptor->reserved = 0;
 }
 
-#define IDT_MAX_DESCRIPTORS 48
+void idt_set_task_gate(uint8_t vector, uint16_t tss_selector)
+{
+    idt_entry_t *descriptor = &idt[vector];
+
+    // the offset is unused by task gates
+    descriptor->isr_low = 0;
+    descriptor->kernel_cs = tss_selector;
+    descriptor->attributes = IDT_GATE_TASK;
+    descriptor->isr_high = 0;
+    descriptor->reserved = 0;
+}
+
+#define IDT_MAX_DESCRIPTORS 50
 
 static bool vectors[IDT_MAX_DESCRIPTORS];
 extern void *isr_stub_table[];
 
-void isr_pause()
-{
-    __asm__ volatile("cli");
-}
-
 void isr_resume()
 {
+    irqsoff_end();
+
     __asm__ volatile("sti");
 }
 
@@ -0,0 +1,271 @@
+#include <input.h>
+#include <irq.h>
+#include <irqsoff.h>
+#include <irqstat.h>
+#include <keyboard.h>
+#include <percpu.h>
+#include <pic.h>
+#include <random.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sync.h>
+#include <trace.h>
+#include <workqueue.h>
+
+/// @brief The amount of TSC cycles a hardware interrupt's top half may take.
+///        Anything slower than that belongs in a deferred work item.
+#define TOP_HALF_BUDGET_CYCLES 20000
+
+/// @brief The maximum amount of registered handlers, over all vectors
+#define IRQ_ACTION_COUNT 32
+
+/// @brief The amount of `int` round trips `irqlat` measures
+#define IRQ_LATENCY_ROUNDS 1000
+
+typedef struct irq_action
+{
+    irq_handler_t handler;
+    void *ctx;
+    struct irq_action *next;
+} irq_action_t;
+
+typedef struct
+{
+    uint32_t count;
+    /// @brief Amount of times the top half took longer than the budget
+    uint32_t overruns;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    /// @brief Interrupts no registered handler claimed
+    uint32_t unhandled;
+    uint32_t spurious;
+} top_half_stats_t;
+
+static irq_action_t actions[IRQ_ACTION_COUNT];
+static int action_count;
+
+/// The handlers of each vector, in registration order
+static irq_action_t *irq_table[IRQ_VECTOR_COUNT];
+
+static top_half_stats_t top_half_stats[IRQ_VECTOR_COUNT];
+
+/// The frame of the interrupt each CPU is handling
+static DEFINE_PER_CPU(irq_frame_t *, irq_regs);
+
+bool irq_register(uint8_t vector, irq_handler_t handler, void *ctx)
+{
+    if (vector >= IRQ_VECTOR_COUNT || action_count == IRQ_ACTION_COUNT)
+    {
+        return false;
+    }
+
+    irq_action_t *action = &actions[action_count++];
+    action->handler = handler;
+    action->ctx = ctx;
+    action->next = NULL;
+
+    irq_flags_t flags = irq_save();
+
+    irq_action_t **link = &irq_table[vector];
+
+    while (*link)
+    {
+        link = &(*link)->next;
+    }
+
+    *link = action;
+
+    irq_restore(flags);
+
+    return true;
+}
+
+static void report_unhandled_irq(uint32_t vector, void *data)
+{
+    (void)data;
+
+    printf("Hardware interrupt #%d received\n", vector - IRQ_VECTOR_BASE);
+}
+
+static void report_top_half_overrun(uint32_t vector, void *data)
+{
+    (void)data;
+
+    printf("IRQ %d top half took %d cycles (budget: %d)\n",
+           vector - IRQ_VECTOR_BASE, top_half_stats[vector].max_cycles,
+           TOP_HALF_BUDGET_CYCLES);
+}
+
+static void account_top_half(uint32_t vector, uint32_t cycles)
+{
+    top_half_stats_t *stats = &top_half_stats[vector];
+
+    stats->count++;
+    stats->total_cycles += cycles;
+
+    if (cycles > TOP_HALF_BUDGET_CYCLES)
+    {
+        stats->overruns++;
+
+        // only new worst cases are reported, to avoid flooding the terminal
+        if (cycles > stats->max_cycles)
+        {
+            work_queue(report_top_half_overrun, vector, NULL);
+        }
+    }
+
+    if (cycles > stats->max_cycles)
+    {
+        stats->max_cycles = cycles;
+    }
+}
+
+/// @brief The top half of hardware interrupt handling. The registered
+///        handlers only acknowledge their devices and defer everything else
+///        with `work_queue`.
+void irq_dispatch(irq_frame_t *frame)
+{
+    uint64_t start = rdtsc();
+    uint32_t vector = frame->vector;
+    bool from_pic = vector >= IRQ_VECTOR_BASE &&
+                    vector < IRQ_VECTOR_BASE + IRQ_LINES;
+
+    if (from_pic && pic_is_spurious(vector - IRQ_VECTOR_BASE))
+    {
+        top_half_stats[vector].spurious++;
+        return;
+    }
+
+    TRACE(irq_entry, vector);
+
+    bool handled = false;
+    irq_frame_t *interrupted_regs = this_cpu(irq_regs);
+    this_cpu(irq_regs) = frame;
+
+    for (irq_action_t *action = irq_table[vector]; action;
+         action = action->next)
+    {
+        handled |= action->handler(action->ctx);
+    }
+
+    this_cpu(irq_regs) = interrupted_regs;
+
+    if (!handled)
+    {
+        top_half_stats[vector].unhandled++;
+        work_queue(report_unhandled_irq, vector, NULL);
+    }
+
+    if (from_pic)
+    {
+        pic_eoi(vector - IRQ_VECTOR_BASE);
+    }
+
+    TRACE(irq_exit, vector);
+
+    uint64_t end = rdtsc();
+
+    account_top_half(vector, (uint32_t)(end - start));
+    irqstat_record(vector, start, end);
+    irqsoff_record_interrupt(vector, frame->eflags, start, end);
+}
+
+irq_frame_t *irq_get_regs(void)
+{
+    return this_cpu(irq_regs);
+}
+
+static bool selftest_irq(void *ctx)
+{
+    (void)ctx;
+
+    return true;
+}
+
+/// @brief Returns the average round trip of `int vector`, in TSC cycles
+#define MEASURE_INT_ROUND_TRIP(vector, min)                                    \
+    ({                                                                         \
+        uint64_t total = 0;                                                    \
+        *(min) = UINT32_MAX;                                                   \
+                                                                               \
+        for (int i = 0; i < IRQ_LATENCY_ROUNDS; i++)                           \
+        {                                                                      \
+            uint64_t start = rdtsc();                                          \
+            __asm__ volatile("int %0" : : "i"(vector) : "memory");             \
+            uint32_t cycles = (uint32_t)(rdtsc() - start);                     \
+                                                                               \
+            total += cycles;                                                   \
+            if (cycles < *(min))                                               \
+            {                                                                  \
+                *(min) = cycles;                                               \
+            }                                                                  \
+        }                                                                      \
+                                                                               \
+        (uint32_t)(total / IRQ_LATENCY_ROUNDS);                                \
+    })
+
+void print_irq_latency()
+{
+    uint32_t fast_min, generic_min;
+
+    uint32_t fast_avg = MEASURE_INT_ROUND_TRIP(IRQ_VECTOR_SELFTEST, &fast_min);
+    uint32_t generic_avg =
+        MEASURE_INT_ROUND_TRIP(IRQ_VECTOR_SELFTEST_GENERIC, &generic_min);
+
+    printf("interrupt round trip (cycles, %d rounds)\n", IRQ_LATENCY_ROUNDS);
+    printf("fast path:    min %d  avg %d\n", fast_min, fast_avg);
+    printf("generic path: min %d  avg %d\n", generic_min, generic_avg);
+}
+
+void print_top_half_stats()
+{
+    printf("irq  count  avg  max  overruns  unhandled  spurious "
+           "(budget: %d cycles)\n",
+           TOP_HALF_BUDGET_CYCLES);
+
+    for (int vector = IRQ_VECTOR_BASE; vector < IRQ_VECTOR_COUNT; vector++)
+    {
+        top_half_stats_t *stats = &top_half_stats[vector];
+
+        if (stats->count == 0 && stats->spurious == 0)
+        {
+            continue;
+        }
+
+        uint32_t avg =
+            stats->count ? (uint32_t)(stats->total_cycles / stats->count) : 0;
+
+        printf("%d  %d  %d  %d  %d  %d  %d\n", vector - IRQ_VECTOR_BASE,
+               stats->count, avg, stats->max_cycles, stats->overruns,
+               stats->unhandled, stats->spurious);
+    }
+
+    uint32_t executed, overflows;
+    workqueue_get_stats(&executed, &overflows);
+
+    printf("deferred work: %d executed, %d dropped\n", executed, overflows);
+    printf("keyboard events: %d dropped\n", keyboard_overflows());
+}
+
+void init_tophalf()
+{
+    irq_register(IRQ_VECTOR_SELFTEST, selftest_irq, NULL);
+
+    scratchpad_cmd_t tophalf_cmd = {
+        .callback = print_top_half_stats,
+        .name = "tophalf",
+        .name_len = 7,
+    };
+
+    add_command(tophalf_cmd);
+
+    scratchpad_cmd_t irqlat_cmd = {
+        .callback = print_irq_latency,
+        .name = "irqlat",
+        .name_len = 6,
+    };
+
+    add_command(irqlat_cmd);
+}
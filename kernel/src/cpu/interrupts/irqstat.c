@@ -0,0 +1,176 @@
+#include <histogram.h>
+#include <input.h>
+#include <irq.h>
+#include <irqstat.h>
+#include <percpu.h>
+#include <serial.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sync.h>
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t last_entry;
+    histogram_t duration;
+    histogram_t interarrival;
+} irqstat_vector_t;
+
+typedef struct
+{
+    irqstat_vector_t vectors[IRQ_VECTOR_COUNT];
+} irqstat_t;
+
+/// Only written by the interrupt handlers of the CPU the instance belongs to,
+/// which don't nest, so no locking is needed. Readers may see a histogram
+/// that's one sample behind its count, which doesn't matter for statistics.
+static DEFINE_PER_CPU(irqstat_t, irqstats);
+
+void irqstat_record(uint32_t vector, uint64_t entry, uint64_t exit)
+{
+    if (vector >= IRQ_VECTOR_COUNT)
+    {
+        return;
+    }
+
+    irqstat_vector_t *stats = &this_cpu(irqstats).vectors[vector];
+
+    if (stats->count != 0)
+    {
+        histogram_add(&stats->interarrival, entry - stats->last_entry);
+    }
+
+    stats->count++;
+    stats->last_entry = entry;
+    histogram_add(&stats->duration, exit - entry);
+}
+
+static void print_irqstat_summary(unsigned int cpu)
+{
+    printf("cpu %d  vec  count  avg gap  p50 dur  p99 dur\n", cpu);
+
+    for (uint32_t vector = 0; vector < IRQ_VECTOR_COUNT; vector++)
+    {
+        irqstat_vector_t *stats = &per_cpu(irqstats, cpu).vectors[vector];
+
+        if (stats->count == 0)
+        {
+            continue;
+        }
+
+        printf("       %d  %u  %u  ", vector, stats->count,
+               histogram_average(&stats->interarrival));
+        histogram_print_bucket(histogram_percentile(&stats->duration, 50));
+        printf("  ");
+        histogram_print_bucket(histogram_percentile(&stats->duration, 99));
+        printf("\n");
+    }
+}
+
+static void print_irqstat_vector(unsigned int cpu, uint32_t vector)
+{
+    irqstat_vector_t *stats = &per_cpu(irqstats, cpu).vectors[vector];
+
+    printf("cpu %d vector %d: %u interrupts\n", cpu, vector, stats->count);
+
+    histogram_print(&stats->duration, "duration");
+    histogram_print(&stats->interarrival, "time between interrupts");
+}
+
+/// @brief Writes the statistics of all CPUs to the serial line, one row per
+///        non-empty histogram bucket.
+static void export_irqstat_csv(void)
+{
+    serial_printf("# irqstat begin\n");
+    serial_printf("cpu,vector,metric,bucket,value\n");
+
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        for (uint32_t vector = 0; vector < IRQ_VECTOR_COUNT; vector++)
+        {
+            irqstat_vector_t *stats = &per_cpu(irqstats, cpu).vectors[vector];
+
+            if (stats->count == 0)
+            {
+                continue;
+            }
+
+            serial_printf("%d,%d,count,,%u\n", cpu, vector, stats->count);
+
+            for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+            {
+                if (stats->duration.buckets[bucket])
+                {
+                    serial_printf("%d,%d,duration,%d,%u\n", cpu, vector,
+                                  bucket, stats->duration.buckets[bucket]);
+                }
+
+                if (stats->interarrival.buckets[bucket])
+                {
+                    serial_printf("%d,%d,interarrival,%d,%u\n", cpu, vector,
+                                  bucket, stats->interarrival.buckets[bucket]);
+                }
+            }
+        }
+    }
+
+    serial_printf("# irqstat end\n");
+}
+
+static void reset_irqstat(void)
+{
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        // keeps this CPU's handlers from recording into a half-cleared table
+        irq_flags_t flags = irq_save();
+        memset(&per_cpu(irqstats, cpu), 0, sizeof(irqstat_t));
+        irq_restore(flags);
+    }
+}
+
+/// @brief `irqstat [csv | reset | <vector>]`
+void irqstat_command(const char *args)
+{
+    if (strcmp(args, "csv") == 0)
+    {
+        export_irqstat_csv();
+        printf("irqstat written to the serial line\n");
+    }
+    else if (strcmp(args, "reset") == 0)
+    {
+        reset_irqstat();
+    }
+    else if (*args >= '0' && *args <= '9')
+    {
+        int vector = atoi(args);
+
+        if (vector >= IRQ_VECTOR_COUNT)
+        {
+            printf("irqstat: no such vector: %d\n", vector);
+            return;
+        }
+
+        print_irqstat_vector(cpu_id(), vector);
+    }
+    else
+    {
+        for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+        {
+            print_irqstat_summary(cpu);
+        }
+    }
+}
+
+void init_irqstat()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = irqstat_command,
+        .name = "irqstat",
+        .name_len = 7,
+    };
+
+    add_command(cmd);
+}
@@ -1,6 +1,12 @@
+#include <fpu.h>
+#include <irq.h>
+#include <irqsoff.h>
+#include <irqstat.h>
+#include <ksym.h>
 #include <panic.h>
 #include <pic.h>
 #include <ports.h>
+#include <random.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -52,47 +58,6 @@ typedef struct
     uint32_t eip, cs, eflags;
 } interrupt_state_t;
 
-void handle_hw_interrupt(int32_t int_no)
-{
-    switch (int_no)
-    {
-    case 0:
-        break;
-    case 1:
-        uint8_t scancode = inb(0x60);
-
-        bool was_pressed = (scancode & 128) == 0;
-        uint8_t key = scancode & (~128);
-
-        tty_t *active_tty = get_active_tty();
-
-        if (active_tty->on_keypress)
-        {
-            // the user callback may enter an infinite loop,
-            // so we should send an EOI signal to the PIC before
-            // calling the user callback. we will return early
-            // to avoid the usual call to pic_eoi at the end of
-            // this function.
-            //
-            // it shouldn't be much of an issue if another keypress
-            // is received when handling keypresses.
-            pic_eoi(int_no);
-
-            active_tty->on_keypress(key, was_pressed,
-                                    active_tty->keypress_callback_data);
-
-            return;
-        }
-
-        break;
-    default:
-        printf("Hardware interrupt #%d received\n", int_no);
-        break;
-    }
-
-    pic_eoi(int_no);
-}
-
 void print_interrupt(interrupt_state_t *state)
 {
     if (state->int_no > 0x1F)
@@ -106,14 +71,16 @@ void print_interrupt(interrupt_state_t *state)
     }
 
     printf("\n\nCPU state:\n");
-    printf("err_code: %d\n", state->err_code);
-    printf("eip: %d\n", state->eip);
-    printf("cs: %d\n", state->cs);
-    printf("eflags: %d\n", state->eflags);
-    printf("edi: %d\n", state->edi);
-    printf("esi: %d\n", state->esi);
-    printf("ebp: %d\n", state->ebp);
-    printf("esp_dummy: %d\n", state->esp_dummy);
+    printf("eip: ");
+    ksym_print(state->eip);
+    printf("\nerr_code: 0x%x  cs: 0x%x  eflags: 0x%x\n", state->err_code,
+           state->cs, state->eflags);
+    printf("eax: 0x%x  ebx: 0x%x  ecx: 0x%x  edx: 0x%x\n", state->eax,
+           state->ebx, state->ecx, state->edx);
+    printf("esi: 0x%x  edi: 0x%x  ebp: 0x%x  esp: 0x%x\n", state->esi,
+           state->edi, state->ebp, state->esp_dummy);
+
+    print_backtrace(state->ebp);
 }
 
 void fault_interrupt(interrupt_state_t *state)
@@ -127,7 +94,7 @@ void fault_interrupt(interrupt_state_t *state)
     end_kpanic();
 }
 
-void interrupt_handler(interrupt_state_t *state)
+static void handle_interrupt(interrupt_state_t *state)
 {
     if (state->int_no < 32)
     {
@@ -138,6 +105,9 @@ void interrupt_handler(interrupt_state_t *state)
         case 13:
             fault_interrupt(state);
             break;
+        case 7:
+            fpu_device_not_available();
+            break;
         default:
             printf("------------------------------\n");
             printf("Interrupt received\n");
@@ -146,8 +116,25 @@ void interrupt_handler(interrupt_state_t *state)
             break;
         }
     }
+    else if (state->int_no == IRQ_VECTOR_SELFTEST_GENERIC)
+    {
+        // only used to measure the generic path's round trip
+        return;
+    }
     else
     {
-        handle_hw_interrupt(state->int_no - 32);
+        printf("-> Unknown interrupt %d\n", state->int_no);
     }
 }
+
+void interrupt_handler(interrupt_state_t *state)
+{
+    uint64_t entry = rdtsc();
+
+    handle_interrupt(state);
+
+    uint64_t exit = rdtsc();
+
+    irqstat_record(state->int_no, entry, exit);
+    irqsoff_record_interrupt(state->int_no, state->eflags, entry, exit);
+}
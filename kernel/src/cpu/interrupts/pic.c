@@ -16,6 +16,10 @@
 // End-of-Interrupt command code
 #define PIC_EOI 0x20
 
+// Operation Command Word 3: makes the next command port read return the
+// In-Service Register
+#define OCW3_READ_ISR 0x0B
+
 static void io_wait(void)
 {
     outb(0x80, 0);
@@ -62,4 +66,47 @@ void pic_eoi(uint8_t irq)
     }
 
     outb(PIC1_COMMAND, PIC_EOI);
+}
+
+void pic_unmask(uint8_t irq)
+{
+    uint16_t port = PIC1_DATA;
+
+    if (irq >= 8)
+    {
+        port = PIC2_DATA;
+        irq -= 8;
+
+        // the slave PIC is only reachable through the cascade line
+        outb(PIC1_DATA, inb(PIC1_DATA) & ~(1 << 2));
+    }
+
+    outb(port, inb(port) & ~(1 << irq));
+}
+
+bool pic_is_spurious(uint8_t irq)
+{
+    if (irq != 7 && irq != 15)
+    {
+        return false;
+    }
+
+    uint16_t command = irq == 7 ? PIC1_COMMAND : PIC2_COMMAND;
+
+    outb(command, OCW3_READ_ISR);
+
+    // a real IRQ7/IRQ15 is marked as in-service, a spurious one isn't
+    if (inb(command) & (1 << 7))
+    {
+        return false;
+    }
+
+    // the master doesn't know that the slave's interrupt was spurious, it
+    // still sees its cascade line in service
+    if (irq == 15)
+    {
+        outb(PIC1_COMMAND, PIC_EOI);
+    }
+
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <input.h>
+#include <percpu.h>
+#include <stacks.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// Unused stack memory is filled with this value. The lowest word that no
+/// longer holds it is the stack's high-water mark.
+#define STACK_PAINT 0xCAFEF00D
+
+/// Bytes right below the current stack pointer that are not painted, so
+/// that painting the boot stack doesn't clobber the painting function's frame
+#define STACK_PAINT_RED_ZONE 256
+
+typedef struct
+{
+    const char *name;
+    uint8_t *bottom;
+    uint32_t size;
+} kernel_stack_t;
+
+// defined in `boot.S`
+extern uint8_t stack_bottom[];
+extern uint8_t stack_top[];
+
+static uint8_t irq_stacks[MAX_CPUS][IRQ_STACK_SIZE] __attribute__((aligned(16)));
+static uint8_t double_fault_stack[FAULT_STACK_SIZE] __attribute__((aligned(16)));
+static uint8_t nmi_stack[FAULT_STACK_SIZE] __attribute__((aligned(16)));
+
+DEFINE_PER_CPU(uint8_t *, irq_stack_top);
+DEFINE_PER_CPU(uint32_t, irq_stack_depth);
+
+static kernel_stack_t stacks[MAX_CPUS + 3];
+static int stack_count;
+
+static void register_stack(const char *name, uint8_t *bottom, uint32_t size)
+{
+    kernel_stack_t stack = {
+        .name = name,
+        .bottom = bottom,
+        .size = size,
+    };
+
+    stacks[stack_count++] = stack;
+}
+
+static void paint_stack(uint8_t *bottom, uint8_t *top)
+{
+    for (uint32_t *word = (uint32_t *)bottom; word < (uint32_t *)top; word++)
+    {
+        *word = STACK_PAINT;
+    }
+}
+
+/// @brief Returns the maximum amount of bytes the stack ever used
+static uint32_t stack_high_water(kernel_stack_t *stack)
+{
+    uint32_t *word = (uint32_t *)stack->bottom;
+    uint32_t *top = (uint32_t *)(stack->bottom + stack->size);
+
+    while (word < top && *word == STACK_PAINT)
+    {
+        word++;
+    }
+
+    return (uint32_t)((uint8_t *)top - (uint8_t *)word);
+}
+
+uint8_t *double_fault_stack_top(void)
+{
+    return double_fault_stack + FAULT_STACK_SIZE;
+}
+
+uint8_t *nmi_stack_top(void)
+{
+    return nmi_stack + FAULT_STACK_SIZE;
+}
+
+void setup_stacks(void)
+{
+    // the boot stack is in use, so only the part below us is painted
+    uint8_t *boot_stack_used =
+        (uint8_t *)__builtin_frame_address(0) - STACK_PAINT_RED_ZONE;
+    paint_stack(stack_bottom, boot_stack_used);
+    register_stack("boot", stack_bottom, stack_top - stack_bottom);
+
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        paint_stack(irq_stacks[cpu], irq_stacks[cpu] + IRQ_STACK_SIZE);
+        per_cpu(irq_stack_top, cpu) = irq_stacks[cpu] + IRQ_STACK_SIZE;
+        register_stack("irq", irq_stacks[cpu], IRQ_STACK_SIZE);
+    }
+
+    paint_stack(double_fault_stack, double_fault_stack + FAULT_STACK_SIZE);
+    register_stack("double fault", double_fault_stack, FAULT_STACK_SIZE);
+
+    paint_stack(nmi_stack, nmi_stack + FAULT_STACK_SIZE);
+    register_stack("nmi", nmi_stack, FAULT_STACK_SIZE);
+}
+
+void print_stacks()
+{
+    printf("stack  size  high-water\n");
+
+    for (int i = 0; i < stack_count; i++)
+    {
+        kernel_stack_t *stack = &stacks[i];
+
+        printf("%s  %d  %d\n", stack->name, stack->size,
+               stack_high_water(stack));
+    }
+}
+
+void init_stacks()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = print_stacks,
+        .name = "stacks",
+        .name_len = 6,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,102 @@
+#include <ksym.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// The table generated by `tools/ksyms.py`
+extern const uint32_t ksym_count;
+extern const uint32_t ksym_addresses[];
+extern const uint16_t ksym_name_offsets[];
+extern const char ksym_names[];
+
+// Defined by the linker script
+extern uint8_t etext[];
+
+// Stacks live in .bss, frame pointers outside of it are garbage
+extern uint8_t sbss[];
+extern uint8_t ebss[];
+
+const char *ksym_lookup(uintptr_t address, uint32_t *offset)
+{
+    if (ksym_count == 0 || address < ksym_addresses[0] ||
+        address >= (uintptr_t)etext)
+    {
+        return NULL;
+    }
+
+    // find the last symbol at or below the address
+    uint32_t low = 0;
+    uint32_t high = ksym_count - 1;
+
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low + 1) / 2;
+
+        if (ksym_addresses[middle] <= address)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    *offset = address - ksym_addresses[low];
+
+    return &ksym_names[ksym_name_offsets[low]];
+}
+
+void ksym_print(uintptr_t address)
+{
+    uint32_t offset;
+    const char *name = ksym_lookup(address, &offset);
+
+    if (name)
+    {
+        printf("%s+0x%x", name, offset);
+    }
+    else
+    {
+        printf("0x%x", address);
+    }
+}
+
+bool stack_frame_is_valid(uintptr_t ebp)
+{
+    return (ebp & 3) == 0 && ebp >= (uintptr_t)sbss &&
+           ebp + 8 <= (uintptr_t)ebss;
+}
+
+void print_backtrace(uintptr_t ebp)
+{
+    printf("backtrace:\n");
+
+    for (int depth = 0; depth < BACKTRACE_MAX_DEPTH; depth++)
+    {
+        if (!stack_frame_is_valid(ebp))
+        {
+            return;
+        }
+
+        const uintptr_t *frame = (const uintptr_t *)ebp;
+
+        if (frame[1] == 0)
+        {
+            return;
+        }
+
+        printf("  ");
+        ksym_print(frame[1]);
+        printf("\n");
+
+        // stacks grow down, so the callers' frames are at higher addresses
+        if (frame[0] <= ebp)
+        {
+            return;
+        }
+
+        ebp = frame[0];
+    }
+}
@@ -0,0 +1,231 @@
+#include <game.h>
+#include <histogram.h>
+#include <keyboard.h>
+#include <metrics.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <timer.h>
+#include <trace.h>
+#include <tty.h>
+
+DEFINE_COUNTER(game_frames);
+DEFINE_COUNTER(game_steps);
+/// @brief The cells that the compositor wrote to the ttys
+DEFINE_COUNTER(game_cells_written);
+DEFINE_HISTOGRAM(game_render_cycles);
+
+static const terminal_entry_color_t game_blank_color = {
+    .foreground = TTY_COLOR_WHITE,
+    .background = TTY_COLOR_BLACK,
+};
+
+void game_canvas_fill(game_canvas_t *canvas, char c,
+                      terminal_entry_color_t color)
+{
+    uint16_t cell = vga_entry_pack((terminal_entry_t){c, color});
+
+    for (size_t i = 0; i < BUFFER_SIZE; i++)
+    {
+        canvas->cells[i] = cell;
+    }
+}
+
+void game_canvas_put(game_canvas_t *canvas, int32_t x, int32_t y, char c,
+                     terminal_entry_color_t color)
+{
+    if (x < 0 || x >= VGA_WIDTH || y < 0 || y >= VGA_HEIGHT)
+    {
+        return;
+    }
+
+    canvas->cells[y * VGA_WIDTH + x] =
+        vga_entry_pack((terminal_entry_t){c, color});
+}
+
+uint32_t game_canvas_present(game_canvas_t *canvas, tty_t *tty)
+{
+    // compares two cells at a time, most of the screen doesn't change
+    const vga_cell_pair_t *from = (const vga_cell_pair_t *)canvas->cells;
+    vga_cell_pair_t *shown = (vga_cell_pair_t *)canvas->shown;
+    vga_cell_pair_t *to = (vga_cell_pair_t *)tty->buffer;
+    uint32_t written = 0;
+
+    for (size_t i = 0; i < BUFFER_SIZE / 2; i++)
+    {
+        if (from[i] != shown[i])
+        {
+            shown[i] = from[i];
+            to[i] = from[i];
+            written++;
+        }
+    }
+
+    if (written)
+    {
+        counter_add(game_cells_written, written * 2);
+        tty_flush(tty);
+    }
+
+    return written * 2;
+}
+
+static void game_key_handler(const key_event_t *event, void *data)
+{
+    game_runtime_t *runtime = (game_runtime_t *)data;
+
+    // the next frame shows the event's effect
+    tty_mark_input(runtime->tty, event);
+
+    if (event->pressed && event->key < GAME_KEYS)
+    {
+        runtime->input.pressed[event->key / 32] |= 1u << (event->key % 32);
+    }
+}
+
+/// @brief Returns the input for the frame's updates and starts collecting
+///        the next frame's key presses
+static game_input_t game_take_input(game_runtime_t *runtime)
+{
+    game_input_t input = runtime->input;
+
+    memset(&runtime->input, 0, sizeof(runtime->input));
+
+    for (uint32_t key = 0; key < GAME_KEYS; key++)
+    {
+        if (key_is_held(key))
+        {
+            input.held[key / 32] |= 1u << (key % 32);
+        }
+    }
+
+    return input;
+}
+
+static void game_render(game_runtime_t *runtime)
+{
+    uint64_t start = rdtsc();
+
+    runtime->game->render(runtime->state, &runtime->canvas);
+    game_canvas_present(&runtime->canvas, runtime->tty);
+
+    histogram_record(game_render_cycles, rdtsc() - start);
+}
+
+/// @brief Runs the updates that are due and renders the result
+/// @returns Whether the game goes on
+static bool game_frame(game_runtime_t *runtime)
+{
+    uint64_t now = rdtsc();
+    uint64_t interval = now - runtime->last_frame;
+
+    runtime->last_frame = now;
+
+    TRACE(game_frame, (uint32_t)interval);
+    counter_inc(game_frames);
+    histogram_add(&runtime->frame_times, interval);
+
+    game_input_t input = game_take_input(runtime);
+
+    for (int steps = 0; runtime->next_step <= now; steps++)
+    {
+        if (steps == GAME_MAX_STEPS_PER_FRAME)
+        {
+            runtime->next_step = now + runtime->step_cycles;
+            break;
+        }
+
+        counter_inc(game_steps);
+
+        if (!runtime->game->update(runtime->state, &input))
+        {
+            return false;
+        }
+
+        // a press is seen by a single update
+        memset(input.pressed, 0, sizeof(input.pressed));
+        runtime->next_step += runtime->step_cycles;
+    }
+
+    game_render(runtime);
+
+    return true;
+}
+
+static void game_finish(game_runtime_t *runtime)
+{
+    // Alt+F<n> can still activate the tty, whose keys must not reach the
+    // finished game
+    tty_set_keypress_callback(runtime->tty, NULL, NULL);
+    set_active_tty(&kernel_tty);
+
+    printf("%s ran %u frames\n", runtime->game->name,
+           runtime->frame_times.count);
+    histogram_print(&runtime->frame_times, "frame times in cycles:");
+}
+
+static void game_loop(coroutine_t *co)
+{
+    game_runtime_t *runtime = (game_runtime_t *)co->data;
+
+    co_begin(co);
+
+    while (true)
+    {
+        co_sleep_until(co, runtime->next_step);
+
+        if (!game_frame(runtime))
+        {
+            break;
+        }
+    }
+
+    game_finish(runtime);
+
+    co_end(co);
+}
+
+bool game_is_running(game_runtime_t *runtime)
+{
+    return coroutine_is_running(&runtime->co);
+}
+
+bool game_start(game_runtime_t *runtime, const game_t *game, void *state,
+                tty_t *tty)
+{
+    if (game_is_running(runtime))
+    {
+        return false;
+    }
+
+    runtime->game = game;
+    runtime->state = state;
+    runtime->tty = tty;
+    runtime->step_cycles = (uint64_t)game->step_us * timer_tsc_khz() / 1000;
+
+    memset(&runtime->input, 0, sizeof(runtime->input));
+    memset(&runtime->frame_times, 0, sizeof(runtime->frame_times));
+
+    // the callback is only set while the game's coroutine is running, which
+    // clears it when the game ends
+    tty_set_keypress_callback(tty, game_key_handler, runtime);
+    tty->cursor_visible = false;
+
+    tty_initialize(tty);
+    set_active_tty(tty);
+
+    // `tty_initialize` left the tty blank
+    game_canvas_fill(&runtime->canvas, ' ', game_blank_color);
+    memcpy(runtime->canvas.shown, runtime->canvas.cells,
+           sizeof(runtime->canvas.shown));
+    game_render(runtime);
+
+    runtime->last_frame = rdtsc();
+    runtime->next_step = runtime->last_frame + runtime->step_cycles;
+
+    coroutine_spawn(&runtime->co, game->name, game_loop, runtime);
+
+    return true;
+}
@@ -1,11 +1,16 @@
+#include <coroutine.h>
 #include <input.h>
+#include <metrics.h>
 #include <panic.h>
 #include <ports.h>
+#include <random.h>
+#include <serial.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <trace.h>
 #include <tty.h>
 
 #define HANDLE_KEY(KEY, LW, HI)                                                \
@@ -27,7 +32,7 @@ typedef struct
     /// @brief The index in the scratchpad at which the
     ///        next character will be written
     int next_insert_ptr;
-    /// @brief Currently pressed modifiers
+    /// @brief Modifiers present during the last key event
     uint16_t modifiers;
     /// @brief Registered TTY commands
     scratchpad_cmd_t commands[128];
@@ -40,19 +45,6 @@ static inline bool is_any_modifier_present(scratchpad_t *scratchpad,
     return (scratchpad->modifiers & present_modifiers) != 0;
 }
 
-static inline void set_modifier_state(scratchpad_t *scratchpad, bool present,
-                                      uint16_t modifier)
-{
-    if (present)
-    {
-        scratchpad->modifiers |= modifier;
-    }
-    else
-    {
-        scratchpad->modifiers &= ~modifier;
-    }
-}
-
 bool is_shift_pressed(scratchpad_t *scratchpad)
 {
     return is_any_modifier_present(scratchpad, MOD_SHIFT_L | MOD_SHIFT_R);
@@ -103,51 +95,69 @@ void tty_write_scratchpad(char *buf)
     tty_flush(&kernel_tty);
 }
 
-void handle_scratchpad(scratchpad_t *scratchpad)
+DEFINE_COUNTER(scratchpad_lines);
+DEFINE_COUNTER(commands_executed);
+DEFINE_HISTOGRAM(command_cycles);
+
+void scratchpad_execute(scratchpad_t *scratchpad, const char *line)
 {
     for (int i = 0; i < scratchpad->command_count; i++)
     {
         scratchpad_cmd_t *cmd = &scratchpad->commands[i];
 
-        if (memcmp(&scratchpad->data, cmd->name, cmd->name_len) == 0)
+        if (memcmp(line, cmd->name, cmd->name_len) != 0)
         {
-            (cmd->callback)();
-            goto cleanup;
+            continue;
         }
+
+        const char *args = line + cmd->name_len;
+
+        // the name has to be followed by the arguments, `tetris` must not run
+        // when `tetrisx` was typed
+        if (*args != '\0' && *args != ' ')
+        {
+            continue;
+        }
+
+        while (*args == ' ')
+        {
+            args++;
+        }
+
+        TRACE(command_entry, i);
+        uint64_t start = rdtsc();
+
+        (cmd->callback)(args);
+
+        counter_inc(commands_executed);
+        histogram_record(command_cycles, rdtsc() - start);
+        TRACE(command_exit, i);
+        return;
     }
 
-    printf("Unknown command: %s\n", &scratchpad->data);
+    printf("Unknown command: %s\n", line);
+}
+
+void handle_scratchpad(scratchpad_t *scratchpad)
+{
+    counter_inc(scratchpad_lines);
+    scratchpad_execute(scratchpad, scratchpad->data);
 
-cleanup:
     memset(&scratchpad->data, 0, sizeof(scratchpad->data));
     scratchpad->next_insert_ptr = 0;
 }
 
-void write_scratchpad(keys_t key, bool was_pressed, void *data)
+void write_scratchpad(const key_event_t *event, void *data)
 {
     scratchpad_t *scratchpad = (scratchpad_t *)data;
+    keys_t key = event->key;
 
-    if (!was_pressed)
-    {
-        switch (key)
-        {
-        case KB_LShift:
-            set_modifier_state(scratchpad, false, MOD_SHIFT_L);
-            break;
-        case KB_RShift:
-            set_modifier_state(scratchpad, false, MOD_SHIFT_R);
-            break;
-        case KB_LAlt:
-            set_modifier_state(scratchpad, false, MOD_ALT_L);
-            break;
-        case KB_LCtrl:
-            set_modifier_state(scratchpad, false, MOD_CTRL_L);
-            break;
-        default:
-            break;
-        }
-    }
-    else
+    scratchpad->modifiers = event->modifiers;
+
+    // every event redraws the scratchpad below
+    tty_mark_input(&kernel_tty, event);
+
+    if (event->pressed)
     {
         switch (key)
         {
@@ -229,26 +239,14 @@ void write_scratchpad(keys_t key, bool was_pressed, void *data)
             handle_scratchpad(scratchpad);
             break;
 
+        // modifiers are tracked by the keyboard driver
         case KB_LShift:
-            set_modifier_state(scratchpad, true, MOD_SHIFT_L);
-            break;
         case KB_RShift:
-            set_modifier_state(scratchpad, true, MOD_SHIFT_R);
-            break;
         case KB_LAlt:
-            set_modifier_state(scratchpad, true, MOD_ALT_L);
-            break;
         case KB_LCtrl:
-            set_modifier_state(scratchpad, true, MOD_CTRL_L);
-            break;
         case KB_CapsLock:
-            scratchpad->modifiers ^= MOD_CAPS_LOCK;
-            break;
         case KB_NumLock:
-            scratchpad->modifiers ^= MOD_NUM_LOCK;
-            break;
         case KB_ScrollLock:
-            scratchpad->modifiers ^= MOD_SCROLL_LOCK;
             break;
 
         default:
@@ -297,6 +295,63 @@ void write_scratchpad(keys_t key, bool was_pressed, void *data)
 
 scratchpad_t scratchpad;
 
+typedef struct
+{
+    /// @brief Received line + zero byte at the end for null termination
+    char line[257];
+    int length;
+} serial_console_t;
+
+static serial_console_t serial_console;
+static coroutine_t serial_console_co;
+
+/// @brief How often the serial line is polled for received characters
+#define SERIAL_POLL_CYCLES 1000000
+
+/// @brief Written when the serial console starts and after every command
+#define SERIAL_CONSOLE_READY "# ready\n"
+
+/// @brief Reads commands from the serial line and executes them just like the
+///        ones typed into the scratchpad
+static void serial_console_loop(coroutine_t *co)
+{
+    serial_console_t *console = (serial_console_t *)co->data;
+
+    co_begin(co);
+
+    // scripts wait for this line before sending the next command, as the
+    // receiver only buffers a few characters while a command runs
+    serial_printf(SERIAL_CONSOLE_READY);
+
+    while (true)
+    {
+        char c;
+
+        while (serial_try_read(&c))
+        {
+            if (c == '\r' || c == '\n')
+            {
+                if (console->length > 0)
+                {
+                    scratchpad_execute(&scratchpad, console->line);
+                    serial_printf(SERIAL_CONSOLE_READY);
+                }
+
+                memset(&console->line, 0, sizeof(console->line));
+                console->length = 0;
+            }
+            else if (console->length < 256)
+            {
+                console->line[console->length++] = c;
+            }
+        }
+
+        co_sleep(co, SERIAL_POLL_CYCLES);
+    }
+
+    co_end(co);
+}
+
 /// @brief Sets up the writing to scratchpad on `kernel_tty`
 void setup_input()
 {
@@ -308,4 +363,15 @@ void setup_input()
 void add_command(scratchpad_cmd_t cmd)
 {
     scratchpad_add_command(&scratchpad, cmd);
+}
+
+void execute_command(const char *line)
+{
+    scratchpad_execute(&scratchpad, line);
+}
+
+void start_serial_console()
+{
+    coroutine_spawn(&serial_console_co, "serial", serial_console_loop,
+                    &serial_console);
 }
\ No newline at end of file
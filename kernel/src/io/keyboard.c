@@ -0,0 +1,257 @@
+#include <coroutine.h>
+#include <input.h>
+#include <inputlat.h>
+#include <irq.h>
+#include <keyboard.h>
+#include <pic.h>
+#include <ports.h>
+#include <random.h>
+#include <replay.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sync.h>
+#include <trace.h>
+#include <tty.h>
+
+#define KEYBOARD_DATA 0x60
+
+/// The prefix byte of extended scancodes
+#define SCANCODE_EXTENDED 0xE0
+
+#define KEY_COUNT 128
+
+typedef struct
+{
+    key_event_t events[KEY_EVENT_RING_SIZE];
+    /// @brief Only written by the producer (the keyboard interrupt)
+    volatile uint32_t head;
+    /// @brief Only written by the consumer (the dispatcher)
+    volatile uint32_t tail;
+    volatile uint32_t overflows;
+    /// @brief Signalled for every pushed event
+    co_event_t event;
+} key_event_ring_t;
+
+static key_event_ring_t ring;
+
+/// @brief One bit per key, set while the key is held down
+static volatile uint32_t key_state[KEY_COUNT / 32];
+
+static volatile uint16_t modifiers;
+
+static coroutine_t dispatcher_co;
+
+static uint32_t next_event_id;
+
+static void set_modifier(uint16_t modifier, bool present)
+{
+    if (present)
+    {
+        modifiers |= modifier;
+    }
+    else
+    {
+        modifiers &= ~modifier;
+    }
+}
+
+static void update_modifiers(keys_t key, bool pressed)
+{
+    switch (key)
+    {
+    case KB_LShift:
+        set_modifier(MOD_SHIFT_L, pressed);
+        break;
+    case KB_RShift:
+        set_modifier(MOD_SHIFT_R, pressed);
+        break;
+    case KB_LAlt:
+        set_modifier(MOD_ALT_L, pressed);
+        break;
+    case KB_LCtrl:
+        set_modifier(MOD_CTRL_L, pressed);
+        break;
+    case KB_CapsLock:
+        if (pressed)
+        {
+            modifiers ^= MOD_CAPS_LOCK;
+        }
+        break;
+    case KB_NumLock:
+        if (pressed)
+        {
+            modifiers ^= MOD_NUM_LOCK;
+        }
+        break;
+    case KB_ScrollLock:
+        if (pressed)
+        {
+            modifiers ^= MOD_SCROLL_LOCK;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void ring_push(const key_event_t *event)
+{
+    uint32_t head = ring.head;
+    uint32_t tail = __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail == KEY_EVENT_RING_SIZE)
+    {
+        ring.overflows++;
+        return;
+    }
+
+    ring.events[head & (KEY_EVENT_RING_SIZE - 1)] = *event;
+
+    __atomic_store_n(&ring.head, head + 1, __ATOMIC_RELEASE);
+
+    co_event_signal(&ring.event);
+}
+
+/// @brief Turns the scancode into an event. Only called by the ring's
+///        producer, with interrupts disabled.
+static void handle_scancode(uint8_t scancode, uint64_t timestamp)
+{
+    // extended keys are reported as their non-extended counterparts, e.g. the
+    // arrow keys as the keypad keys
+    if (scancode == SCANCODE_EXTENDED)
+    {
+        return;
+    }
+
+    bool pressed = (scancode & 128) == 0;
+    keys_t key = scancode & (~128);
+
+    if (pressed)
+    {
+        key_state[key / 32] |= 1u << (key % 32);
+    }
+    else
+    {
+        key_state[key / 32] &= ~(1u << (key % 32));
+    }
+
+    update_modifiers(key, pressed);
+
+    key_event_t event = {
+        .timestamp = timestamp,
+        .id = next_event_id++,
+        .modifiers = modifiers,
+        .key = key,
+        .pressed = pressed,
+    };
+
+    ring_push(&event);
+}
+
+void keyboard_irq(void)
+{
+    uint64_t timestamp = rdtsc();
+    uint8_t scancode = inb(KEYBOARD_DATA);
+
+    replay_record_scancode(scancode);
+    handle_scancode(scancode, timestamp);
+}
+
+void keyboard_inject(uint8_t scancode)
+{
+    // the keyboard interrupt is the ring's only producer, so it must not run
+    // while we're pushing the event
+    irq_flags_t flags = irq_save();
+
+    handle_scancode(scancode, rdtsc());
+
+    irq_restore(flags);
+}
+
+bool keyboard_poll(key_event_t *event)
+{
+    uint32_t tail = ring.tail;
+
+    if (__atomic_load_n(&ring.head, __ATOMIC_ACQUIRE) == tail)
+    {
+        return false;
+    }
+
+    *event = ring.events[tail & (KEY_EVENT_RING_SIZE - 1)];
+
+    __atomic_store_n(&ring.tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool key_is_held(keys_t key)
+{
+    return (key_state[key / 32] >> (key % 32)) & 1;
+}
+
+uint16_t keyboard_modifiers(void)
+{
+    return modifiers;
+}
+
+uint32_t keyboard_overflows(void)
+{
+    return ring.overflows;
+}
+
+/// @brief Forwards the keyboard events to the active tty
+static void dispatcher_loop(coroutine_t *co)
+{
+    co_begin(co);
+
+    while (true)
+    {
+        // every pushed event signals the event exactly once
+        co_await_event(co, &ring.event);
+
+        key_event_t event;
+
+        if (!keyboard_poll(&event))
+        {
+            continue;
+        }
+
+        input_latency_dispatched(&event);
+        TRACE(key_event, event.key | (event.pressed << 8));
+
+        // Alt+F1 to Alt+F8 switch between the ttys
+        if (event.pressed && (event.modifiers & (MOD_ALT_L | MOD_ALT_R)) &&
+            event.key >= KB_F1 && event.key < KB_F1 + TTY_SWITCH_KEYS)
+        {
+            tty_switch(event.key - KB_F1);
+            continue;
+        }
+
+        tty_t *active_tty = get_active_tty();
+
+        if (active_tty->on_keypress)
+        {
+            active_tty->on_keypress(&event, active_tty->keypress_callback_data);
+        }
+    }
+
+    co_end(co);
+}
+
+static bool keyboard_irq_handler(void *ctx)
+{
+    (void)ctx;
+
+    keyboard_irq();
+
+    return true;
+}
+
+void setup_keyboard(void)
+{
+    coroutine_spawn(&dispatcher_co, "keyboard", dispatcher_loop, NULL);
+
+    irq_register(IRQ_VECTOR(1), keyboard_irq_handler, NULL);
+    pic_unmask(1);
+}
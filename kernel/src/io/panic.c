@@ -1,6 +1,9 @@
-#include <idt.h>
+#include <ksym.h>
+#include <qemu.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <sync.h>
 #include <tty.h>
 
 void start_kpanic()
@@ -9,9 +12,11 @@ void start_kpanic()
     // first of all, the kernel panic message must be written without any
     // interrupts, but also, the system is likely in an invalid state, where it
     // shouldn't execute anymore, and executing interrupts would in fact cause
-    // code to execute
-    isr_pause();
+    // code to execute. Interrupts are never enabled again.
+    (void)irq_save();
 
+    // the panic may have interrupted the tty code while it held the VGA lock
+    tty_panic_takeover();
     set_active_tty(&kernel_tty);
 
     tty_clear(&kernel_tty, TTY_COLOR_BLUE);
@@ -23,6 +28,9 @@ __attribute__((__noreturn__)) void end_kpanic()
 {
     printf("\n------------------------------");
 
+    // lets scripted QEMU runs fail right away instead of timing out
+    qemu_exit(QEMU_EXIT_PANIC);
+
     while (1)
     {
         __asm__ volatile("hlt");
@@ -41,5 +49,8 @@ __attribute__((__noreturn__)) void kpanic(const char *__restrict format, ...)
 
     va_end(args);
 
+    printf("\n");
+    print_backtrace((uintptr_t)__builtin_frame_address(0));
+
     end_kpanic();
 }
@@ -0,0 +1,30 @@
+#include <input.h>
+#include <ports.h>
+#include <qemu.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void qemu_exit(uint8_t code)
+{
+    outb(QEMU_DEBUG_EXIT_PORT, code);
+}
+
+/// @brief `exit [code]`
+void exit_command(const char *args)
+{
+    qemu_exit((uint8_t)atoi(args));
+
+    printf("not running under QEMU with the isa-debug-exit device\n");
+}
+
+void init_qemu()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = exit_command,
+        .name = "exit",
+        .name_len = 4,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,276 @@
+#include <coroutine.h>
+#include <input.h>
+#include <keyboard.h>
+#include <random.h>
+#include <replay.h>
+#include <serial.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <timer.h>
+
+/// An event is packed into 32 bits: the tick in the upper 24, the scancode in
+/// the lower 8. At 1 kHz, that's enough for recordings of over 4 hours.
+#define REPLAY_EVENT(tick, scancode) (((tick) << 8) | (scancode))
+#define REPLAY_EVENT_TICK(event) ((event) >> 8)
+#define REPLAY_EVENT_SCANCODE(event) ((uint8_t)((event) & 0xFF))
+#define REPLAY_MAX_TICK ((1u << 24) - 1)
+
+typedef enum
+{
+    REPLAY_IDLE,
+    REPLAY_RECORDING,
+    REPLAY_PLAYING,
+} replay_state_t;
+
+typedef struct
+{
+    volatile replay_state_t state;
+    /// @brief The timer tick the recording or the replay started at
+    uint64_t start_tick;
+
+    uint32_t events[REPLAY_MAX_EVENTS];
+    /// @brief Only written by the keyboard interrupt while recording
+    volatile uint32_t event_count;
+    /// @brief Scancodes that didn't fit in the recording
+    volatile uint32_t dropped;
+
+    uint32_t seeds[REPLAY_MAX_SEEDS];
+    uint32_t seed_count;
+
+    /// @brief The next event and seed to replay
+    uint32_t event_position;
+    uint32_t seed_position;
+    /// @brief TSC cycles per timer tick, how long the replay sleeps while
+    ///        waiting for the next event
+    uint32_t cycles_per_tick;
+} replay_t;
+
+static replay_t replay;
+static coroutine_t replay_co;
+
+void replay_record_scancode(uint8_t scancode)
+{
+    if (replay.state != REPLAY_RECORDING)
+    {
+        return;
+    }
+
+    uint64_t tick = timer_ticks() - replay.start_tick;
+
+    if (replay.event_count == REPLAY_MAX_EVENTS || tick > REPLAY_MAX_TICK)
+    {
+        replay.dropped++;
+        return;
+    }
+
+    replay.events[replay.event_count] = REPLAY_EVENT((uint32_t)tick, scancode);
+    replay.event_count++;
+}
+
+uint32_t replay_seed(void)
+{
+    if (replay.state == REPLAY_PLAYING &&
+        replay.seed_position < replay.seed_count)
+    {
+        return replay.seeds[replay.seed_position++];
+    }
+
+    uint32_t seed = (uint32_t)rdtsc();
+
+    if (replay.state == REPLAY_RECORDING &&
+        replay.seed_count < REPLAY_MAX_SEEDS)
+    {
+        replay.seeds[replay.seed_count++] = seed;
+    }
+
+    return seed;
+}
+
+/// @brief Injects the recorded scancodes once their ticks come
+static void replay_loop(coroutine_t *co)
+{
+    replay_t *state = (replay_t *)co->data;
+
+    co_begin(co);
+
+    while (state->state == REPLAY_PLAYING &&
+           state->event_position < state->event_count)
+    {
+        uint32_t event = state->events[state->event_position];
+
+        if (timer_ticks() - state->start_tick < REPLAY_EVENT_TICK(event))
+        {
+            co_sleep(co, state->cycles_per_tick);
+            continue;
+        }
+
+        keyboard_inject(REPLAY_EVENT_SCANCODE(event));
+        state->event_position++;
+    }
+
+    if (state->state == REPLAY_PLAYING)
+    {
+        state->state = REPLAY_IDLE;
+    }
+
+    co_end(co);
+}
+
+static void replay_clear(void)
+{
+    replay.state = REPLAY_IDLE;
+    replay.event_count = 0;
+    replay.dropped = 0;
+    replay.seed_count = 0;
+}
+
+static void replay_start_recording(void)
+{
+    replay_clear();
+
+    replay.start_tick = timer_ticks();
+    replay.state = REPLAY_RECORDING;
+}
+
+static void replay_start_playing(void)
+{
+    if (coroutine_is_running(&replay_co))
+    {
+        printf("a replay is still running, stop it first\n");
+        return;
+    }
+
+    uint32_t cycles_per_tick = timer_tsc_khz() * 1000 / TIMER_HZ;
+
+    replay.cycles_per_tick = cycles_per_tick;
+    replay.event_position = 0;
+    replay.seed_position = 0;
+    replay.start_tick = timer_ticks();
+    replay.state = REPLAY_PLAYING;
+
+    coroutine_spawn(&replay_co, "replay", replay_loop, &replay);
+}
+
+/// @brief Writes the recording to the serial line as the commands that load
+///        it again
+static void replay_dump(void)
+{
+    serial_printf("# replay begin\n");
+    serial_printf("replay clear\n");
+
+    for (uint32_t i = 0; i < replay.seed_count; i++)
+    {
+        serial_printf("replay seed %u\n", replay.seeds[i]);
+    }
+
+    for (uint32_t i = 0; i < replay.event_count; i++)
+    {
+        serial_printf("replay event %u %u\n",
+                      REPLAY_EVENT_TICK(replay.events[i]),
+                      REPLAY_EVENT_SCANCODE(replay.events[i]));
+    }
+
+    serial_printf("# replay end\n");
+}
+
+/// @brief `replay event <tick> <scancode>`
+static void replay_add_event(const char *args)
+{
+    uint32_t tick = (uint32_t)atoi(args);
+
+    while (*args >= '0' && *args <= '9')
+    {
+        args++;
+    }
+
+    uint32_t scancode = (uint32_t)atoi(args);
+
+    if (replay.state != REPLAY_IDLE ||
+        replay.event_count == REPLAY_MAX_EVENTS || tick > REPLAY_MAX_TICK ||
+        scancode > 0xFF)
+    {
+        printf("can't add the event\n");
+        return;
+    }
+
+    replay.events[replay.event_count++] = REPLAY_EVENT(tick, scancode);
+}
+
+/// @brief `replay seed <seed>`
+static void replay_add_seed(const char *args)
+{
+    if (replay.state != REPLAY_IDLE || replay.seed_count == REPLAY_MAX_SEEDS)
+    {
+        printf("can't add the seed\n");
+        return;
+    }
+
+    // `atoi` stops at 2^31, the seeds use all 32 bits
+    uint32_t seed = 0;
+
+    while (*args >= '0' && *args <= '9')
+    {
+        seed = seed * 10 + (*args++ - '0');
+    }
+
+    replay.seeds[replay.seed_count++] = seed;
+}
+
+/// @brief `replay [record|stop|play|dump|clear|seed <n>|event <tick> <code>]`
+void replay_command(const char *args)
+{
+    if (strcmp(args, "record") == 0)
+    {
+        replay_start_recording();
+        printf("recording keyboard input\n");
+    }
+    else if (strcmp(args, "stop") == 0)
+    {
+        replay.state = REPLAY_IDLE;
+        printf("stopped\n");
+    }
+    else if (strcmp(args, "play") == 0)
+    {
+        replay_start_playing();
+    }
+    else if (strcmp(args, "dump") == 0)
+    {
+        replay_dump();
+        printf("recording written to the serial line\n");
+    }
+    else if (strcmp(args, "clear") == 0)
+    {
+        replay_clear();
+    }
+    else if (memcmp(args, "seed ", 5) == 0)
+    {
+        replay_add_seed(args + 5);
+    }
+    else if (memcmp(args, "event ", 6) == 0)
+    {
+        replay_add_event(args + 6);
+    }
+    else
+    {
+        static const char *const states[] = {"idle", "recording", "playing"};
+
+        printf("%s, %u events (%u dropped), %u seeds\n", states[replay.state],
+               replay.event_count, replay.dropped, replay.seed_count);
+        printf("usage: replay record|stop|play|dump|clear\n");
+    }
+}
+
+void init_replay()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = replay_command,
+        .name = "replay",
+        .name_len = 6,
+    };
+
+    add_command(cmd);
+}
@@ -1,8 +1,18 @@
+#include <metrics.h>
 #include <ports.h>
+#include <serial.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #define COM1 0x3f8
 
+DEFINE_COUNTER(serial_bytes);
+/// @brief Characters that had to wait for the transmitter to drain
+DEFINE_COUNTER(serial_tx_waits);
+
 int init_serial()
 {
     outb(COM1 + 1, 0x00); // Disable all interrupts
@@ -35,10 +45,16 @@ static int is_transmit_empty()
 
 void write_serial(char a)
 {
-    while (is_transmit_empty() == 0)
-        ;
+    if (is_transmit_empty() == 0)
+    {
+        counter_inc(serial_tx_waits);
+
+        while (is_transmit_empty() == 0)
+            ;
+    }
 
     outb(COM1, a);
+    counter_inc(serial_bytes);
 }
 
 static int serial_received()
@@ -53,4 +69,35 @@ char read_serial()
     }
 
     return inb(COM1);
-}
\ No newline at end of file
+}
+
+bool serial_try_read(char *c)
+{
+    if (serial_received() == 0)
+    {
+        return false;
+    }
+
+    *c = inb(COM1);
+    return true;
+}
+
+static int serial_sink(int c, void *ctx)
+{
+    (void)ctx;
+
+    write_serial((char)c);
+    return c;
+}
+
+int serial_printf(const char *format, ...)
+{
+    va_list parameters;
+    va_start(parameters, format);
+
+    int written = vcbprintf(serial_sink, NULL, format, parameters);
+
+    va_end(parameters);
+
+    return written;
+}
@@ -0,0 +1,102 @@
+#include <irq.h>
+#include <pic.h>
+#include <random.h>
+#include <ports.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sync.h>
+#include <timer.h>
+
+#define PIT_CHANNEL0 0x40
+#define PIT_COMMAND 0x43
+
+// Channel 0, lobyte/hibyte access, mode 3 (square wave generator)
+#define PIT_CMD_CH0_SQUARE_WAVE 0x36
+
+/// The PIT's input clock in Hz
+#define PIT_BASE_FREQUENCY 1193182
+
+/// The amount of ticks the TSC is calibrated over
+#define TSC_CALIBRATION_TICKS 10
+
+static DEFINE_LOCK_CLASS(ticks_lock_class, "ticks");
+
+static uint64_t ticks;
+static seqlock_t ticks_lock = SEQLOCK_INIT(&ticks_lock_class);
+
+static uint32_t tsc_khz;
+
+static bool timer_irq(void *ctx)
+{
+    (void)ctx;
+
+    timer_tick();
+
+    return true;
+}
+
+void setup_timer(void)
+{
+    uint16_t divisor = PIT_BASE_FREQUENCY / TIMER_HZ;
+
+    outb(PIT_COMMAND, PIT_CMD_CH0_SQUARE_WAVE);
+    outb(PIT_CHANNEL0, (uint8_t)(divisor & 0xFF));
+    outb(PIT_CHANNEL0, (uint8_t)((divisor >> 8) & 0xFF));
+
+    irq_register(IRQ_VECTOR(0), timer_irq, NULL);
+    pic_unmask(0);
+}
+
+void timer_tick(void)
+{
+    write_seqlock(&ticks_lock);
+    ticks++;
+    write_sequnlock(&ticks_lock);
+}
+
+uint64_t timer_ticks(void)
+{
+    // the 64-bit counter cannot be read atomically on i386, so we retry if an
+    // interrupt updated it in-between reading both halves
+    uint64_t now;
+    uint32_t sequence;
+
+    do
+    {
+        sequence = read_seqbegin(&ticks_lock);
+        now = ticks;
+    } while (read_seqretry(&ticks_lock, sequence));
+
+    return now;
+}
+
+uint32_t timer_tsc_khz(void)
+{
+    if (tsc_khz != 0)
+    {
+        return tsc_khz;
+    }
+
+    // start right at a tick, so that the measured interval is whole ticks
+    uint64_t start_tick = timer_ticks();
+
+    while (timer_ticks() == start_tick)
+    {
+        cpu_relax();
+    }
+
+    uint64_t start = rdtsc();
+    start_tick = timer_ticks();
+
+    while (timer_ticks() - start_tick < TSC_CALIBRATION_TICKS)
+    {
+        cpu_relax();
+    }
+
+    uint64_t cycles = rdtsc() - start;
+
+    tsc_khz = (uint32_t)(cycles * TIMER_HZ / 1000 / TSC_CALIBRATION_TICKS);
+
+    return tsc_khz;
+}
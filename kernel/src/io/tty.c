@@ -1,23 +1,65 @@
-#include <idt.h>
+#include <hal.h>
+#include <inputlat.h>
+#include <metrics.h>
 #include <ports.h>
+#include <random.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <sync.h>
+#include <trace.h>
 #include <tty.h>
 
 #ifdef SERIAL_WRITE_TTY
 #include <serial.h>
 #endif
 
-#define VGA_MEMORY 0xB8000
-
 tty_t kernel_tty;
 
 tty_t *active_tty = &kernel_tty;
 
-static inline void vga_set_cursor_position(size_t x, size_t y)
+/// The ttys in the order they were initialized, Alt+F<n> activates the n-th
+static tty_t *ttys[TTY_SWITCH_KEYS];
+static uint32_t tty_count;
+
+/// @brief The next VGA page to give to a tty
+static uint32_t next_page;
+
+static DEFINE_LOCK_CLASS(vga_lock_class, "vga");
+
+/// Protects the VGA memory and the CRTC index/data register pairs
+static spinlock_t vga_lock = SPINLOCK_INIT(&vga_lock_class);
+
+DEFINE_COUNTER(tty_flushes);
+DEFINE_COUNTER(tty_flush_bytes);
+DEFINE_HISTOGRAM(tty_flush_cycles);
+DEFINE_COUNTER(tty_scrolls);
+DEFINE_COUNTER(tty_escapes);
+
+/// ANSI numbers the colors with red as bit 0 and blue as bit 2, VGA the other
+/// way around
+static const terminal_color_t ansi_colors[8] = {
+    TTY_COLOR_BLACK, TTY_COLOR_RED,     TTY_COLOR_GREEN, TTY_COLOR_BROWN,
+    TTY_COLOR_BLUE,  TTY_COLOR_MAGENTA, TTY_COLOR_CYAN,  TTY_COLOR_LIGHT_GREY,
+};
+
+/// @brief The bit that makes a color bright, e.g. red to light red
+#define TTY_COLOR_BRIGHT 8
+
+static inline void vga_set_start_page(uint32_t page)
 {
-    uint16_t pos = y * VGA_WIDTH + x;
+    uint16_t start = page * VGA_PAGE_CELLS;
+
+    outb(0x3D4, 0x0C);
+    outb(0x3D5, (uint8_t)((start >> 8) & 0xFF));
+
+    outb(0x3D4, 0x0D);
+    outb(0x3D5, (uint8_t)(start & 0xFF));
+}
+
+static inline void vga_set_cursor_position(uint32_t page, size_t x, size_t y)
+{
+    uint16_t pos = page * VGA_PAGE_CELLS + y * VGA_WIDTH + x;
 
     outb(0x3D4, 0x0F);
     outb(0x3D5, (uint8_t)(pos & 0xFF));
@@ -44,13 +86,6 @@ static inline void vga_set_cursor_visible(bool visible)
     outb(0x3D5, cursor_start);
 }
 
-static inline uint16_t vga_entry_pack(terminal_entry_t terminal_entry)
-{
-    return (uint16_t)(terminal_entry.character) |
-           (uint16_t)(terminal_entry.color.background) << 12 |
-           (uint16_t)(terminal_entry.color.foreground) << 8;
-}
-
 static inline terminal_entry_t vga_entry_unpack(uint16_t packed_entry)
 {
     terminal_entry_t entry = {
@@ -65,11 +100,32 @@ static inline terminal_entry_t vga_entry_unpack(uint16_t packed_entry)
     return entry;
 }
 
+static inline uint16_t *vga_page(uint32_t page)
+{
+    return (uint16_t *)(VGA_MEMORY + page * VGA_PAGE_CELLS * sizeof(uint16_t));
+}
+
+static inline bool tty_has_page(tty_t *tty)
+{
+    return tty->buffer != tty->shadow;
+}
+
 static size_t vga_index(size_t x, size_t y)
 {
     return y * VGA_WIDTH + x;
 }
 
+/// @brief Clamps `position` to `0..limit - 1`
+static size_t clamp_position(int32_t position, size_t limit)
+{
+    if (position < 0)
+    {
+        return 0;
+    }
+
+    return (size_t)position < limit ? (size_t)position : limit - 1;
+}
+
 void tty_set_color(tty_t *tty, terminal_entry_color_t color)
 {
     tty->color = color;
@@ -100,14 +156,21 @@ terminal_entry_t tty_read_at(tty_t *tty, size_t x, size_t y)
 
 void tty_move_up(tty_t *tty)
 {
-    for (size_t y = 1; y < TTY_HEIGHT; y++)
-    {
-        for (size_t x = 0; x < VGA_WIDTH; x++)
-        {
-            const terminal_entry_t entry = tty_read_at(tty, x, y);
+    TRACE(tty_move_up, 0);
+    counter_inc(tty_scrolls);
 
-            tty_set_entry_at(tty, entry, x, y - 1);
-        }
+    const size_t top = tty->scroll_top;
+    const size_t bottom = tty->scroll_bottom;
+
+    // two cells at a time, the rows move towards the start of the buffer, so
+    // copying forwards reads every cell before overwriting it
+    vga_cell_pair_t *to = (vga_cell_pair_t *)(tty->buffer + vga_index(0, top));
+    vga_cell_pair_t *end =
+        (vga_cell_pair_t *)(tty->buffer + vga_index(0, bottom - 1));
+
+    for (; to < end; to++)
+    {
+        to[0] = to[VGA_WIDTH / 2];
     }
 
     const terminal_entry_t blank_terminal_entry = {
@@ -115,22 +178,23 @@ void tty_move_up(tty_t *tty)
         .color = tty->color,
     };
 
-    for (size_t x = 0; x < VGA_WIDTH; x++)
-    {
-        tty_set_entry_at(tty, blank_terminal_entry, x, TTY_HEIGHT - 1);
-    }
+    memset16(tty->buffer + vga_index(0, bottom - 1),
+             vga_entry_pack(blank_terminal_entry), VGA_WIDTH);
 }
 
 void tty_next_line(tty_t *tty)
 {
     tty->cursor_col = 0;
-    tty->cursor_row += 1;
 
-    if (tty->cursor_row == TTY_HEIGHT)
+    // below the scroll region, the last row doesn't scroll
+    if (tty->cursor_row + 1 == tty->scroll_bottom)
     {
-        tty->cursor_row = TTY_HEIGHT - 1;
         tty_move_up(tty);
     }
+    else if (tty->cursor_row + 1 < TTY_HEIGHT)
+    {
+        tty->cursor_row += 1;
+    }
 }
 
 void tty_next_char(tty_t *tty)
@@ -146,7 +210,10 @@ void tty_next_char(tty_t *tty)
 void tty_put_entry(tty_t *tty, terminal_entry_t entry)
 {
 #ifdef SERIAL_WRITE_TTY
-    write_serial((char)entry.character);
+    if (tty == &kernel_tty)
+    {
+        write_serial((char)entry.character);
+    }
 #endif
 
     if (entry.character == '\n')
@@ -160,21 +227,415 @@ void tty_put_entry(tty_t *tty, terminal_entry_t entry)
     tty_next_char(tty);
 }
 
-static void tty_put_char(tty_t *tty, const char data)
+/// @brief The color bits of the cells written with the tty's color
+static uint16_t tty_attribute(const tty_t *tty)
 {
-    const terminal_entry_t entry = {
-        .character = data,
+    const terminal_entry_t attribute_entry = {
+        .character = 0,
         .color = tty->color,
     };
 
-    tty_put_entry(tty, entry);
+    return vga_entry_pack(attribute_entry);
+}
+
+/// @brief Returns the length of the prefix of `data` without control
+///        characters, i.e. bytes below ' '
+static size_t tty_printable_length(const char *data, size_t size)
+{
+    size_t i = 0;
+
+    // four bytes at a time, a byte below 0x20 borrows from its top bit
+    for (; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t))
+    {
+        uint32_t bytes;
+        __builtin_memcpy(&bytes, data + i, sizeof(bytes));
+
+        if ((bytes - 0x20202020u) & ~bytes & 0x80808080u)
+        {
+            break;
+        }
+    }
+
+    while (i < size && (uint8_t)data[i] >= ' ')
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/// @brief Writes `data` from the cursor up to the first control character or
+///        the end of the line, whichever comes first, without moving to the
+///        next line
+/// @param attribute The color bits of the cells
+/// @returns The amount of written characters
+static size_t tty_write_run(tty_t *tty, const char *data, size_t size,
+                            uint16_t attribute)
+{
+    size_t room = VGA_WIDTH - tty->cursor_col;
+    size_t length = tty_printable_length(data, size < room ? size : room);
+    uint16_t *cells = tty->buffer + vga_index(tty->cursor_col, tty->cursor_row);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        cells[i] = attribute | (uint8_t)data[i];
+    }
+
+    tty->cursor_col += length;
+
+    return length;
+}
+
+/// @brief Erases the cells from `from` up to, but not including, `to`
+static void tty_erase(tty_t *tty, size_t from, size_t to)
+{
+    const terminal_entry_t blank_terminal_entry = {
+        .character = ' ',
+        .color = tty->color,
+    };
+
+    if (from < to)
+    {
+        memset16(tty->buffer + from, vga_entry_pack(blank_terminal_entry),
+                 to - from);
+    }
+}
+
+/// @brief Moves the cursor, keeping it on the screen above the scratchpad
+static void tty_move_cursor(tty_t *tty, int32_t row, int32_t col)
+{
+    tty->cursor_row = clamp_position(row, TTY_HEIGHT);
+    tty->cursor_col = clamp_position(col, VGA_WIDTH);
+}
+
+/// @brief Returns the `index`th parameter, or `fallback` if it's omitted or 0
+static int32_t tty_escape_param(const tty_escape_t *escape, uint32_t index,
+                                int32_t fallback)
+{
+    uint16_t value = 0;
+
+    if (index < escape->count && index < TTY_ESCAPE_PARAMS)
+    {
+        value = escape->params[index];
+    }
+
+    return value ? value : fallback;
+}
+
+static void tty_select_graphic_rendition(tty_t *tty, const tty_escape_t *escape)
+{
+    // ESC [ m is ESC [ 0 m
+    uint32_t count = escape->count ? escape->count : 1;
+
+    if (count > TTY_ESCAPE_PARAMS)
+    {
+        count = TTY_ESCAPE_PARAMS;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint16_t param = escape->params[i];
+        terminal_entry_color_t *color = &tty->color;
+
+        if (param == 0)
+        {
+            *color = tty->default_color;
+            tty->bold = false;
+        }
+        else if (param == 1)
+        {
+            color->foreground |= TTY_COLOR_BRIGHT;
+            tty->bold = true;
+        }
+        else if (param == 22)
+        {
+            color->foreground &= ~TTY_COLOR_BRIGHT;
+            tty->bold = false;
+        }
+        else if (param >= 30 && param <= 37)
+        {
+            // e.g. ESC [ 1 ; 32 m is light green
+            color->foreground =
+                ansi_colors[param - 30] | (tty->bold ? TTY_COLOR_BRIGHT : 0);
+        }
+        else if (param == 39)
+        {
+            color->foreground = tty->default_color.foreground;
+        }
+        else if (param >= 40 && param <= 47)
+        {
+            color->background = ansi_colors[param - 40];
+        }
+        else if (param == 49)
+        {
+            color->background = tty->default_color.background;
+        }
+        else if (param >= 90 && param <= 97)
+        {
+            color->foreground = ansi_colors[param - 90] | TTY_COLOR_BRIGHT;
+        }
+        else if (param >= 100 && param <= 107)
+        {
+            color->background = ansi_colors[param - 100] | TTY_COLOR_BRIGHT;
+        }
+    }
+}
+
+static void tty_set_scroll_region(tty_t *tty, const tty_escape_t *escape)
+{
+    int32_t top = tty_escape_param(escape, 0, 1);
+    int32_t bottom = tty_escape_param(escape, 1, TTY_HEIGHT);
+
+    if (top >= bottom || bottom > TTY_HEIGHT)
+    {
+        return;
+    }
+
+    tty->scroll_top = top - 1;
+    tty->scroll_bottom = bottom;
+    tty_move_cursor(tty, 0, 0);
+}
+
+/// @brief Runs the control sequence whose final byte is `command`
+static void tty_control_sequence(tty_t *tty, char command)
+{
+    const tty_escape_t *escape = &tty->escape;
+    const int32_t row = tty->cursor_row;
+    const int32_t col = tty->cursor_col;
+    const int32_t n = tty_escape_param(escape, 0, 1);
+    const size_t cursor = vga_index(col, row);
+
+    counter_inc(tty_escapes);
+
+    if (escape->private_marker)
+    {
+        if (n == 25 && (command == 'h' || command == 'l'))
+        {
+            tty->cursor_visible = command == 'h';
+        }
+
+        return;
+    }
+
+    switch (command)
+    {
+    case 'A':
+        tty_move_cursor(tty, row - n, col);
+        break;
+    case 'B':
+        tty_move_cursor(tty, row + n, col);
+        break;
+    case 'C':
+        tty_move_cursor(tty, row, col + n);
+        break;
+    case 'D':
+        tty_move_cursor(tty, row, col - n);
+        break;
+    case 'E':
+        tty_move_cursor(tty, row + n, 0);
+        break;
+    case 'F':
+        tty_move_cursor(tty, row - n, 0);
+        break;
+    case 'G':
+        tty_move_cursor(tty, row, n - 1);
+        break;
+    case 'd':
+        tty_move_cursor(tty, n - 1, col);
+        break;
+    case 'H':
+    case 'f':
+        tty_move_cursor(tty, n - 1, tty_escape_param(escape, 1, 1) - 1);
+        break;
+    case 'J':
+        switch (tty_escape_param(escape, 0, 0))
+        {
+        case 0:
+            tty_erase(tty, cursor, vga_index(0, TTY_HEIGHT));
+            break;
+        case 1:
+            tty_erase(tty, 0, cursor + 1);
+            break;
+        case 2:
+            tty_erase(tty, 0, vga_index(0, TTY_HEIGHT));
+            break;
+        }
+        break;
+    case 'K':
+        switch (tty_escape_param(escape, 0, 0))
+        {
+        case 0:
+            tty_erase(tty, cursor, vga_index(0, row + 1));
+            break;
+        case 1:
+            tty_erase(tty, vga_index(0, row), cursor + 1);
+            break;
+        case 2:
+            tty_erase(tty, vga_index(0, row), vga_index(0, row + 1));
+            break;
+        }
+        break;
+    case 'm':
+        tty_select_graphic_rendition(tty, escape);
+        break;
+    case 'r':
+        tty_set_scroll_region(tty, escape);
+        break;
+    case 's':
+        tty->saved_row = tty->cursor_row;
+        tty->saved_col = tty->cursor_col;
+        break;
+    case 'u':
+        tty_move_cursor(tty, tty->saved_row, tty->saved_col);
+        break;
+    }
+}
+
+static void tty_escape_start(tty_t *tty, char c)
+{
+    tty_escape_t *escape = &tty->escape;
+
+    escape->state = TTY_ESCAPE_NONE;
+
+    switch (c)
+    {
+    case '[':
+        escape->state = TTY_ESCAPE_CSI;
+        escape->private_marker = false;
+        escape->count = 0;
+        memset(escape->params, 0, sizeof(escape->params));
+        break;
+    case '7':
+        tty->saved_row = tty->cursor_row;
+        tty->saved_col = tty->cursor_col;
+        break;
+    case '8':
+        tty_move_cursor(tty, tty->saved_row, tty->saved_col);
+        break;
+    case 'c':
+        tty_clear(tty, tty->default_color.background);
+        break;
+    case '\x1b':
+        escape->state = TTY_ESCAPE_START;
+        break;
+    }
+}
+
+static void tty_escape_csi(tty_t *tty, char c)
+{
+    tty_escape_t *escape = &tty->escape;
+
+    if (c >= '0' && c <= '9')
+    {
+        if (escape->count == 0)
+        {
+            escape->count = 1;
+        }
+
+        if (escape->count <= TTY_ESCAPE_PARAMS)
+        {
+            uint16_t *param = &escape->params[escape->count - 1];
+            uint32_t value = *param * 10 + (c - '0');
+
+            *param = value < TTY_ESCAPE_PARAM_MAX ? value
+                                                  : TTY_ESCAPE_PARAM_MAX;
+        }
+    }
+    else if (c == ';')
+    {
+        // an omitted first parameter is still a parameter
+        escape->count = escape->count ? escape->count + 1 : 2;
+    }
+    else if (c == '?')
+    {
+        escape->private_marker = true;
+    }
+    else if (c == '\x1b')
+    {
+        escape->state = TTY_ESCAPE_START;
+    }
+    else if (c >= 0x40 && c <= 0x7E)
+    {
+        escape->state = TTY_ESCAPE_NONE;
+        tty_control_sequence(tty, c);
+    }
+    // intermediate bytes and control characters inside a sequence are dropped
+}
+
+/// @brief Handles a byte that isn't part of a run of printable characters
+static void tty_write_special(tty_t *tty, char c)
+{
+    switch (tty->escape.state)
+    {
+    case TTY_ESCAPE_START:
+        tty_escape_start(tty, c);
+        return;
+    case TTY_ESCAPE_CSI:
+        tty_escape_csi(tty, c);
+        return;
+    case TTY_ESCAPE_NONE:
+        break;
+    }
+
+    switch (c)
+    {
+    case '\n':
+        tty_next_line(tty);
+        break;
+    case '\r':
+        tty->cursor_col = 0;
+        break;
+    case '\x1b':
+        tty->escape.state = TTY_ESCAPE_START;
+        break;
+    default:
+    {
+        // the other control characters show their CP437 glyphs
+        const terminal_entry_t entry = {
+            .character = c,
+            .color = tty->color,
+        };
+
+        tty_set_entry_at(tty, entry, tty->cursor_col, tty->cursor_row);
+        tty_next_char(tty);
+        break;
+    }
+    }
 }
 
 void tty_write(tty_t *tty, const char *data, size_t size)
 {
-    for (size_t i = 0; i < size; i++)
+#ifdef SERIAL_WRITE_TTY
+    // the escape sequences go to the serial terminal as well
+    if (tty == &kernel_tty)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            write_serial(data[i]);
+        }
+    }
+#endif
+
+    uint16_t attribute = tty_attribute(tty);
+    size_t i = 0;
+
+    while (i < size)
     {
-        tty_put_char(tty, data[i]);
+        if (tty->escape.state != TTY_ESCAPE_NONE || (uint8_t)data[i] < ' ')
+        {
+            tty_write_special(tty, data[i++]);
+            // an SGR sequence may have changed the color
+            attribute = tty_attribute(tty);
+            continue;
+        }
+
+        i += tty_write_run(tty, data + i, size - i, attribute);
+
+        // the run filled the line, scrolling at most once
+        if (tty->cursor_col == VGA_WIDTH)
+        {
+            tty_next_line(tty);
+        }
     }
 }
 
@@ -194,27 +655,62 @@ void tty_clear(tty_t *tty, terminal_color_t background)
     };
 
     tty->color = default_color;
+    tty->default_color = default_color;
+    tty->bold = false;
+
+    tty->scroll_top = 0;
+    tty->scroll_bottom = TTY_HEIGHT;
+    tty->saved_row = 0;
+    tty->saved_col = 0;
+    tty->escape.state = TTY_ESCAPE_NONE;
 
     const terminal_entry_t blank_terminal_entry = {
         .character = ' ',
         .color = default_color,
     };
 
-    for (size_t y = 0; y < VGA_HEIGHT; y++)
+    memset16(tty->buffer, vga_entry_pack(blank_terminal_entry), BUFFER_SIZE);
+}
+
+/// @brief Gives the tty a VGA page, or its shadow buffer once the pages ran out
+static void tty_attach(tty_t *tty)
+{
+    if (next_page < TTY_SHARED_PAGE)
     {
-        for (size_t x = 0; x < VGA_WIDTH; x++)
-        {
-            tty_set_entry_at(tty, blank_terminal_entry, x, y);
-        }
+        tty->page = next_page++;
+        tty->buffer = vga_page(tty->page);
+    }
+    else
+    {
+        tty->page = TTY_SHARED_PAGE;
+        tty->buffer = tty->shadow;
+    }
+
+    if (tty_count < TTY_SWITCH_KEYS)
+    {
+        ttys[tty_count++] = tty;
     }
 }
 
 void tty_initialize(tty_t *tty)
 {
+    if (!tty->buffer)
+    {
+        tty_attach(tty);
+    }
+
     tty_clear(tty, TTY_COLOR_BLACK);
     tty_flush(tty);
 }
 
+void tty_initialize_shadow(tty_t *tty)
+{
+    tty->page = TTY_SHARED_PAGE;
+    tty->buffer = tty->shadow;
+
+    tty_initialize(tty);
+}
+
 void tty_set_keypress_callback(tty_t *tty, keypress_callback_t callback,
                                void *data)
 {
@@ -229,21 +725,78 @@ void tty_flush(tty_t *tty)
         return;
     }
 
-    isr_pause();
+    // the writes to a tty with a page of its own are already on the screen
+    size_t bytes = tty_has_page(tty) ? 0 : sizeof(uint16_t[BUFFER_SIZE]);
+
+    TRACE(tty_flush_entry, bytes);
+    uint64_t start = rdtsc();
+
+    irq_flags_t flags = spin_lock_irqsave(&vga_lock);
+
+    if (bytes)
+    {
+        memcpy(vga_page(TTY_SHARED_PAGE), tty->shadow, bytes);
+    }
 
-    memcpy((void *)VGA_MEMORY, tty->buffer, sizeof(uint16_t[BUFFER_SIZE]));
-    vga_set_cursor_position(tty->cursor_col, tty->cursor_row);
+    vga_set_cursor_position(tty->page, tty->cursor_col, tty->cursor_row);
     vga_set_cursor_visible(tty->cursor_visible);
 
-    isr_resume();
+    spin_unlock_irqrestore(&vga_lock, flags);
+
+    counter_inc(tty_flushes);
+    counter_add(tty_flush_bytes, bytes);
+    histogram_record(tty_flush_cycles, rdtsc() - start);
+    TRACE(tty_flush_exit, 0);
+
+    if (tty->input_pending)
+    {
+        tty->input_pending = false;
+        input_latency_flushed(tty->input_event_id, tty->input_timestamp);
+    }
+}
+
+void tty_mark_input(tty_t *tty, const key_event_t *event)
+{
+    if (tty->input_pending)
+    {
+        return;
+    }
+
+    tty->input_pending = true;
+    tty->input_event_id = event->id;
+    tty->input_timestamp = event->timestamp;
 }
 
 void set_active_tty(tty_t *tty)
 {
     active_tty = tty;
+
+    irq_flags_t flags = spin_lock_irqsave(&vga_lock);
+    vga_set_start_page(tty->page);
+    spin_unlock_irqrestore(&vga_lock, flags);
+
     tty_flush(tty);
 }
 
+void tty_panic_takeover(void)
+{
+    // the lock's owner would have been interrupted on this CPU, and never gets
+    // to release it, so every ticket handed out so far is dropped
+    __atomic_store_n(&vga_lock.owner, vga_lock.next_ticket, __ATOMIC_RELEASE);
+}
+
+bool tty_switch(uint32_t index)
+{
+    if (index >= tty_count)
+    {
+        return false;
+    }
+
+    set_active_tty(ttys[index]);
+
+    return true;
+}
+
 tty_t *get_active_tty()
 {
     return active_tty;
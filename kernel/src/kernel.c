@@ -1,31 +1,76 @@
+#include <boottime.h>
+#include <coroutine.h>
+#include <fpu.h>
 #include <gdt.h>
 #include <idt.h>
 #include <input.h>
+#include <keyboard.h>
 #include <paging.h>
 #include <pic.h>
+#include <serial.h>
+#include <stacks.h>
 #include <stdio.h>
+#include <timer.h>
+#include <workqueue.h>
 
 extern void init_tetris();
 extern void init_pong();
+extern void init_coroutines();
+extern void init_tophalf();
+extern void init_irqstat();
+extern void init_lockstat();
+extern void init_irqsoff();
+extern void init_inputlat();
+extern void init_profile();
+extern void init_trace();
+extern void init_stacks();
+extern void init_boottime();
+extern void init_stats();
+extern void init_bench();
+extern void init_qemu();
+extern void init_replay();
 
 void kernel_main(void)
 {
-    setup_input();
-    setup_gdt();
-    setup_pic();
-    setup_idt();
-    setup_paging();
+    boot_stage_record("_start", boot_tsc_start, rdtsc());
 
-    init_tetris();
-    init_pong();
+    BOOT_STAGE(setup_stacks);
+    BOOT_STAGE(init_serial);
+    BOOT_STAGE(setup_input);
+    BOOT_STAGE(setup_gdt);
+    BOOT_STAGE(setup_pic);
+    BOOT_STAGE(setup_timer);
+    BOOT_STAGE(setup_workqueue);
+    BOOT_STAGE(setup_keyboard);
+    BOOT_STAGE(setup_idt);
+    BOOT_STAGE(setup_fpu);
+    BOOT_STAGE(setup_paging);
+    BOOT_STAGE(setup_tss);
+
+    BOOT_STAGE(init_tetris);
+    BOOT_STAGE(init_pong);
+    BOOT_STAGE(init_coroutines);
+    BOOT_STAGE(init_tophalf);
+    BOOT_STAGE(init_irqstat);
+    BOOT_STAGE(init_lockstat);
+    BOOT_STAGE(init_irqsoff);
+    BOOT_STAGE(init_inputlat);
+    BOOT_STAGE(init_profile);
+    BOOT_STAGE(init_trace);
+    BOOT_STAGE(init_stacks);
+    BOOT_STAGE(init_boottime);
+    BOOT_STAGE(init_stats);
+    BOOT_STAGE(init_bench);
+    BOOT_STAGE(init_qemu);
+    BOOT_STAGE(init_replay);
+
+    BOOT_STAGE(start_serial_console);
 
     printf("Hello, world!\n");
     printf("Hello, world1!\n");
     printf("Hello, world2!\n");
     printf("Hello, world3!\n");
 
-    while (1)
-    {
-        __asm__ volatile("hlt");
-    }
+    boot_finished();
+    scheduler_loop();
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include <bench.h>
+#include <cpuid.h>
+#include <input.h>
+#include <serial.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sync.h>
+#include <timer.h>
+
+/// @brief The largest `bench_t.samples`
+#define BENCH_MAX_SAMPLES 1024
+
+/// @brief The maximum amount of benchmarks `bench all` runs
+#define BENCH_MAX_CASES 64
+
+extern const bench_t __start_benches[];
+extern const bench_t __stop_benches[];
+
+static bool bench_initialized;
+static bool bench_has_lfence;
+/// @brief The cycles measured around an empty benchmark
+static uint32_t bench_overhead;
+
+static uint32_t bench_samples[BENCH_MAX_SAMPLES];
+
+static inline uint64_t bench_rdtsc(void)
+{
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+/// @brief Reads the TSC once every earlier instruction completed
+static inline uint64_t bench_begin(void)
+{
+    cpuid(0);
+    return bench_rdtsc();
+}
+
+/// @brief Reads the TSC once the measured code completed, and keeps the
+///        following code from starting before the read
+static inline uint64_t bench_end(void)
+{
+    uint64_t tsc;
+
+    if (bench_has_lfence)
+    {
+        __asm__ volatile("lfence" ::: "memory");
+        tsc = bench_rdtsc();
+        __asm__ volatile("lfence" ::: "memory");
+    }
+    else
+    {
+        // `cpuid` is much slower, but the overhead is subtracted as well
+        cpuid(0);
+        tsc = bench_rdtsc();
+    }
+
+    return tsc;
+}
+
+static void bench_empty(void)
+{
+}
+
+static uint32_t bench_sample(void (*run)(void))
+{
+    irq_flags_t flags = irq_save();
+
+    uint64_t start = bench_begin();
+    run();
+    uint64_t end = bench_end();
+
+    irq_restore(flags);
+
+    uint64_t cycles = end - start;
+    return cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+}
+
+static void bench_sort(uint32_t *samples, uint32_t count)
+{
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint32_t value = samples[i];
+        uint32_t j = i;
+
+        while (j > 0 && samples[j - 1] > value)
+        {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+
+        samples[j] = value;
+    }
+}
+
+static void bench_init(void)
+{
+    if (bench_initialized)
+    {
+        return;
+    }
+
+    bench_has_lfence =
+        (cpuid(CPUID_FEATURES).edx & CPUID_EDX_SSE2) == CPUID_EDX_SSE2;
+
+    uint32_t overhead = UINT32_MAX;
+
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        uint32_t cycles = bench_sample(bench_empty);
+
+        if (cycles < overhead)
+        {
+            overhead = cycles;
+        }
+    }
+
+    bench_overhead = overhead;
+    bench_initialized = true;
+}
+
+void bench_run(const bench_t *bench, bench_result_t *result)
+{
+    bench_init();
+
+    uint32_t samples = bench->samples ? bench->samples : BENCH_SAMPLES;
+
+    if (samples > BENCH_MAX_SAMPLES)
+    {
+        samples = BENCH_MAX_SAMPLES;
+    }
+
+    if (bench->setup)
+    {
+        bench->setup();
+    }
+
+    for (int i = 0; i < BENCH_WARMUP; i++)
+    {
+        bench->run();
+    }
+
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        uint32_t cycles = bench_sample(bench->run);
+
+        bench_samples[i] =
+            cycles > bench_overhead ? cycles - bench_overhead : 0;
+    }
+
+    if (bench->teardown)
+    {
+        bench->teardown();
+    }
+
+    bench_sort(bench_samples, samples);
+
+    result->samples = samples;
+    result->min = bench_samples[0];
+    result->median = bench_samples[samples / 2];
+    result->p99 = bench_samples[samples * 99 / 100];
+}
+
+const bench_t *bench_find(const char *name)
+{
+    for (const bench_t *bench = __start_benches; bench < __stop_benches;
+         bench++)
+    {
+        if (strcmp(bench->name, name) == 0)
+        {
+            return bench;
+        }
+    }
+
+    return NULL;
+}
+
+static void bench_list(void)
+{
+    printf("benchmarks:");
+
+    for (const bench_t *bench = __start_benches; bench < __stop_benches;
+         bench++)
+    {
+        printf(" %s", bench->name);
+    }
+
+    printf("\nusage: bench <name|all>\n");
+}
+
+/// @brief `bench <name|all>`
+void bench_command(const char *args)
+{
+    static bench_result_t results[BENCH_MAX_CASES];
+    const bench_t *first = __start_benches;
+    const bench_t *last = __stop_benches;
+
+    if (*args == '\0')
+    {
+        bench_list();
+        return;
+    }
+
+    if (strcmp(args, "all") != 0)
+    {
+        first = bench_find(args);
+
+        if (!first)
+        {
+            printf("no benchmark named '%s'\n", args);
+            return;
+        }
+
+        last = first + 1;
+    }
+
+    if (last - first > BENCH_MAX_CASES)
+    {
+        last = first + BENCH_MAX_CASES;
+    }
+
+    for (const bench_t *bench = first; bench < last; bench++)
+    {
+        bench_run(bench, &results[bench - first]);
+    }
+
+    // the tty is mirrored to the serial line, so the CSV is written before
+    // the tty output to keep the two apart
+    serial_printf("# bench begin\n");
+    serial_printf("name,samples,min,median,p99\n");
+
+    for (const bench_t *bench = first; bench < last; bench++)
+    {
+        const bench_result_t *result = &results[bench - first];
+
+        serial_printf("%s,%u,%u,%u,%u\n", bench->name, result->samples,
+                      result->min, result->median, result->p99);
+    }
+
+    serial_printf("# bench end\n");
+
+    printf("cycles, timer overhead of %u subtracted:\n", bench_overhead);
+
+    for (const bench_t *bench = first; bench < last; bench++)
+    {
+        const bench_result_t *result = &results[bench - first];
+
+        printf("%s: min %u  median %u  p99 %u", bench->name, result->min,
+               result->median, result->p99);
+
+        if (bench->items && result->median)
+        {
+            uint64_t per_second = (uint64_t)bench->items * timer_tsc_khz() *
+                                  1000 / result->median;
+
+            // printf has no 64-bit conversions
+            if (per_second > UINT32_MAX)
+            {
+                printf("  %uk/s", (uint32_t)(per_second / 1000));
+            }
+            else
+            {
+                printf("  %u/s", (uint32_t)per_second);
+            }
+        }
+
+        printf("\n");
+    }
+}
+
+void init_bench()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = bench_command,
+        .name = "bench",
+        .name_len = 5,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,186 @@
+#include <bench.h>
+#include <hal.h>
+#include <irq.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <tty.h>
+
+/// @brief The length of the string written by `tty_write_long`
+#define BENCH_STRING_LENGTH 1024
+
+/// A tty for the benchmarks to scribble on. Only `kernel_tty` is mirrored to
+/// the serial line, so writing to it doesn't flood COM1. It has no VGA page,
+/// so `tty_flush` copies its whole shadow buffer.
+static tty_t bench_tty;
+
+static uint16_t bench_buffer[BUFFER_SIZE];
+static char bench_string[BENCH_STRING_LENGTH];
+
+static void bench_memcpy_ram(void)
+{
+    memcpy(bench_buffer, bench_tty.shadow, sizeof(bench_buffer));
+}
+
+DEFINE_BENCH(memcpy_ram, .run = bench_memcpy_ram);
+
+static void bench_memcpy_vga_setup(void)
+{
+    memcpy(bench_buffer, kernel_tty.buffer, sizeof(bench_buffer));
+}
+
+static void bench_memcpy_vga(void)
+{
+    // writes back what the kernel tty's page shows, so the screen doesn't
+    // change
+    memcpy(kernel_tty.buffer, bench_buffer, sizeof(bench_buffer));
+}
+
+DEFINE_BENCH(memcpy_vga, .setup = bench_memcpy_vga_setup,
+             .run = bench_memcpy_vga);
+
+static void bench_tty_setup(void)
+{
+    tty_initialize_shadow(&bench_tty);
+}
+
+static void bench_tty_active_setup(void)
+{
+    tty_initialize_shadow(&bench_tty);
+    set_active_tty(&bench_tty);
+}
+
+static void bench_tty_active_teardown(void)
+{
+    set_active_tty(&kernel_tty);
+}
+
+static void bench_tty_flush(void)
+{
+    tty_flush(&bench_tty);
+}
+
+DEFINE_BENCH(tty_flush, .setup = bench_tty_active_setup,
+             .run = bench_tty_flush, .teardown = bench_tty_active_teardown);
+
+static void bench_tty_flush_paged(void)
+{
+    // only moves the cursor, the kernel tty writes to its page directly
+    tty_flush(&kernel_tty);
+}
+
+DEFINE_BENCH(tty_flush_paged, .run = bench_tty_flush_paged);
+
+static void bench_tty_move_up(void)
+{
+    tty_move_up(&bench_tty);
+}
+
+DEFINE_BENCH(tty_move_up, .setup = bench_tty_setup, .run = bench_tty_move_up);
+
+static void bench_tty_write_setup(void)
+{
+    tty_initialize_shadow(&bench_tty);
+
+    for (int i = 0; i < BENCH_STRING_LENGTH; i++)
+    {
+        bench_string[i] = (i % 64 == 63) ? '\n' : 'a' + i % 26;
+    }
+}
+
+static void bench_tty_write(void)
+{
+    tty_write(&bench_tty, bench_string, sizeof(bench_string));
+}
+
+DEFINE_BENCH(tty_write_long, .setup = bench_tty_write_setup,
+             .run = bench_tty_write, .samples = 64,
+             .items = BENCH_STRING_LENGTH);
+
+static void bench_tty_write_screen_setup(void)
+{
+    tty_initialize_shadow(&bench_tty);
+
+    // no newlines, every run fills and scrolls a dozen whole lines
+    for (int i = 0; i < BENCH_STRING_LENGTH; i++)
+    {
+        bench_string[i] = ' ' + i % 95;
+    }
+}
+
+DEFINE_BENCH(tty_write_lines, .setup = bench_tty_write_screen_setup,
+             .run = bench_tty_write, .samples = 64,
+             .items = BENCH_STRING_LENGTH);
+
+static void bench_tty_write_ansi_setup(void)
+{
+    // a status line redrawn in place, a cursor move and two color changes
+    // around every 14 characters
+    static const char chunk[] = "\x1b[1;1H\x1b[32mok\x1b[0m tty_writes ";
+    const int chunk_length = sizeof(chunk) - 1;
+
+    tty_initialize_shadow(&bench_tty);
+
+    for (int i = 0; i < BENCH_STRING_LENGTH; i++)
+    {
+        bench_string[i] = chunk[i % chunk_length];
+    }
+}
+
+DEFINE_BENCH(tty_write_ansi, .setup = bench_tty_write_ansi_setup,
+             .run = bench_tty_write, .samples = 64,
+             .items = BENCH_STRING_LENGTH);
+
+static void bench_tty_clear(void)
+{
+    tty_clear(&bench_tty, TTY_COLOR_BLACK);
+}
+
+DEFINE_BENCH(tty_clear, .setup = bench_tty_setup, .run = bench_tty_clear,
+             .items = BUFFER_SIZE);
+
+static int bench_discard_sink(int c, void *ctx)
+{
+    (void)ctx;
+
+    return c;
+}
+
+static void bench_format(const char *format, ...)
+{
+    va_list parameters;
+    va_start(parameters, format);
+
+    vcbprintf(bench_discard_sink, NULL, format, parameters);
+
+    va_end(parameters);
+}
+
+static void bench_vprintf(void)
+{
+    bench_format("%s: %d %u %x %c %%\n", "bench", -123456, 4000000000u,
+                 0xdeadbeef, 'x');
+}
+
+DEFINE_BENCH(vprintf_mixed, .run = bench_vprintf);
+
+// a host program can't raise interrupts
+#ifndef HOST_BUILD
+
+static void bench_irq_round_trip(void)
+{
+    __asm__ volatile("int %0" : : "i"(IRQ_VECTOR_SELFTEST) : "memory");
+}
+
+DEFINE_BENCH(irq_round_trip, .run = bench_irq_round_trip);
+
+static void bench_irq_round_trip_generic(void)
+{
+    __asm__ volatile("int %0" : : "i"(IRQ_VECTOR_SELFTEST_GENERIC) : "memory");
+}
+
+DEFINE_BENCH(irq_round_trip_generic, .run = bench_irq_round_trip_generic);
+
+#endif
@@ -0,0 +1,128 @@
+#include <boottime.h>
+#include <input.h>
+#include <random.h>
+#include <serial.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <timer.h>
+
+typedef struct
+{
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+} boot_stage_t;
+
+uint64_t boot_tsc_start;
+
+static boot_stage_t boot_stages[BOOT_STAGES_MAX];
+static int boot_stage_count;
+/// @brief Stages that didn't fit in the log
+static int boot_stages_dropped;
+
+static uint64_t boot_tsc_end;
+
+void boot_stage_record(const char *name, uint64_t start, uint64_t end)
+{
+    if (boot_stage_count == BOOT_STAGES_MAX)
+    {
+        boot_stages_dropped++;
+        return;
+    }
+
+    boot_stages[boot_stage_count++] = (boot_stage_t){
+        .name = name,
+        .start = start,
+        .end = end,
+    };
+}
+
+void boot_finished(void)
+{
+    boot_tsc_end = rdtsc();
+}
+
+/// @brief Converts TSC cycles to microseconds
+static uint32_t cycles_to_us(uint64_t cycles, uint32_t khz)
+{
+    return (uint32_t)(cycles * 1000 / khz);
+}
+
+static void boottime_print(uint32_t khz)
+{
+    printf("boot stages (us, TSC at %u kHz):\n", khz);
+
+    for (int i = 0; i < boot_stage_count; i++)
+    {
+        const boot_stage_t *stage = &boot_stages[i];
+
+        printf("  %s: %u (at %u)\n", stage->name,
+               cycles_to_us(stage->end - stage->start, khz),
+               cycles_to_us(stage->start - boot_tsc_start, khz));
+    }
+
+    if (boot_stages_dropped)
+    {
+        printf("  %d stages didn't fit in the log\n", boot_stages_dropped);
+    }
+
+    if (boot_tsc_end)
+    {
+        printf("boot finished after %u us\n",
+               cycles_to_us(boot_tsc_end - boot_tsc_start, khz));
+    }
+}
+
+static void export_boottime_csv(uint32_t khz)
+{
+    serial_printf("# boottime begin\n");
+    serial_printf("stage,start_us,duration_us\n");
+
+    for (int i = 0; i < boot_stage_count; i++)
+    {
+        const boot_stage_t *stage = &boot_stages[i];
+
+        serial_printf("%s,%u,%u\n", stage->name,
+                      cycles_to_us(stage->start - boot_tsc_start, khz),
+                      cycles_to_us(stage->end - stage->start, khz));
+    }
+
+    serial_printf("total,0,%u\n",
+                  cycles_to_us(boot_tsc_end - boot_tsc_start, khz));
+    serial_printf("# boottime end\n");
+}
+
+/// @brief `boottime [csv]`
+void boottime_command(const char *args)
+{
+    // the calibration needs the timer, so it can only happen after the boot
+    uint32_t khz = timer_tsc_khz();
+
+    if (khz == 0)
+    {
+        printf("the TSC frequency is unknown\n");
+        return;
+    }
+
+    if (strcmp(args, "csv") == 0)
+    {
+        export_boottime_csv(khz);
+        printf("boottime written to the serial line\n");
+    }
+    else
+    {
+        boottime_print(khz);
+    }
+}
+
+void init_boottime()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = boottime_command,
+        .name = "boottime",
+        .name_len = 8,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,111 @@
+#include <histogram.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/// @brief The width of the longest bar printed by `histogram_print`
+#define HISTOGRAM_BAR_WIDTH 40
+
+void histogram_add(histogram_t *histogram, uint64_t value)
+{
+    histogram->count++;
+    histogram->total += value;
+    histogram->buckets[histogram_bucket(value)]++;
+
+    uint32_t saturated = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+
+    if (saturated > histogram->max)
+    {
+        histogram->max = saturated;
+    }
+}
+
+uint32_t histogram_average(const histogram_t *histogram)
+{
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)(histogram->total / histogram->count);
+}
+
+uint32_t histogram_percentile(const histogram_t *histogram, uint32_t percent)
+{
+    uint64_t threshold = ((uint64_t)histogram->count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        seen += histogram->buckets[bucket];
+
+        if (seen >= threshold && seen != 0)
+        {
+            return bucket;
+        }
+    }
+
+    return 0;
+}
+
+void histogram_print_bucket(uint32_t bucket)
+{
+    if (bucket == 0)
+    {
+        printf("0");
+    }
+    else if (bucket == HISTOGRAM_BUCKETS - 1)
+    {
+        printf(">=2^%d", bucket - 1);
+    }
+    else
+    {
+        printf("<2^%d", bucket);
+    }
+}
+
+void histogram_print(const histogram_t *histogram, const char *title)
+{
+    uint32_t max = 0;
+
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (histogram->buckets[bucket] > max)
+        {
+            max = histogram->buckets[bucket];
+        }
+    }
+
+    printf("%s (cycles):\n", title);
+
+    if (max == 0)
+    {
+        printf("  no samples\n");
+        return;
+    }
+
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (histogram->buckets[bucket] == 0)
+        {
+            continue;
+        }
+
+        uint32_t width = (uint32_t)((uint64_t)histogram->buckets[bucket] *
+                                    HISTOGRAM_BAR_WIDTH / max);
+
+        if (width == 0)
+        {
+            width = 1;
+        }
+
+        // every `printf` flushes the tty, so the bar is printed at once
+        char bar[HISTOGRAM_BAR_WIDTH + 1];
+        memset(bar, '#', width);
+        bar[width] = '\0';
+
+        printf("  ");
+        histogram_print_bucket(bucket);
+        printf(" %u %s\n", histogram->buckets[bucket], bar);
+    }
+}
@@ -0,0 +1,143 @@
+#include <coroutine.h>
+#include <histogram.h>
+#include <input.h>
+#include <inputlat.h>
+#include <keyboard.h>
+#include <random.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @brief The amount of keystrokes `inputlat test` injects by default
+#define INPUTLAT_TEST_KEYSTROKES 64
+
+/// @brief How long the test waits between injected key events, in TSC cycles
+#define INPUTLAT_TEST_INTERVAL 5000000
+
+/// @brief Bit 7 of a scancode is set for key releases
+#define SCANCODE_RELEASED 0x80
+
+typedef struct
+{
+    /// @brief Time from the interrupt until the dispatcher took the event
+    histogram_t queued;
+    /// @brief Time from the interrupt until the effect was written to VGA
+    histogram_t to_screen;
+
+    uint32_t last_id;
+    uint32_t last_cycles;
+} input_latency_t;
+
+typedef struct
+{
+    /// @brief The key events left to inject
+    uint32_t remaining;
+} inputlat_test_t;
+
+static input_latency_t latency;
+
+static inputlat_test_t inputlat_test;
+static coroutine_t test_co;
+
+void input_latency_dispatched(const key_event_t *event)
+{
+    histogram_add(&latency.queued, rdtsc() - event->timestamp);
+}
+
+void input_latency_flushed(uint32_t id, uint64_t timestamp)
+{
+    uint64_t cycles = rdtsc() - timestamp;
+
+    histogram_add(&latency.to_screen, cycles);
+
+    latency.last_id = id;
+    latency.last_cycles = cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+}
+
+static void print_input_latency(void)
+{
+    histogram_print(&latency.queued, "interrupt to dispatch");
+    histogram_print(&latency.to_screen, "interrupt to screen");
+
+    printf("to screen: %u events, avg %u, max %u, p99 ",
+           latency.to_screen.count, histogram_average(&latency.to_screen),
+           latency.to_screen.max);
+    histogram_print_bucket(histogram_percentile(&latency.to_screen, 99));
+    printf("\nlast: event #%u after %u cycles\n", latency.last_id,
+           latency.last_cycles);
+}
+
+/// @brief Types `1` and erases it with backspace, over and over, so the
+///        scratchpad ends up as it was
+static void inputlat_test_loop(coroutine_t *co)
+{
+    inputlat_test_t *test = (inputlat_test_t *)co->data;
+
+    co_begin(co);
+
+    while (test->remaining > 0)
+    {
+        keyboard_inject(test->remaining % 2 ? KB_Backspace : KB_Key1);
+        co_sleep(co, INPUTLAT_TEST_INTERVAL);
+
+        keyboard_inject((test->remaining % 2 ? KB_Backspace : KB_Key1) |
+                        SCANCODE_RELEASED);
+        co_sleep(co, INPUTLAT_TEST_INTERVAL);
+
+        test->remaining--;
+    }
+
+    print_input_latency();
+
+    co_end(co);
+}
+
+/// @brief `inputlat [reset | test [keystrokes]]`
+void inputlat_command(const char *args)
+{
+    if (strcmp(args, "reset") == 0)
+    {
+        memset(&latency, 0, sizeof(latency));
+    }
+    else if (memcmp(args, "test", 4) == 0 &&
+             (args[4] == '\0' || args[4] == ' '))
+    {
+        if (coroutine_is_running(&test_co))
+        {
+            printf("inputlat: a test is already running\n");
+            return;
+        }
+
+        int keystrokes = atoi(args + 4);
+
+        if (keystrokes <= 0)
+        {
+            keystrokes = INPUTLAT_TEST_KEYSTROKES;
+        }
+
+        memset(&latency, 0, sizeof(latency));
+
+        // every keystroke is followed by a backspace
+        inputlat_test.remaining = 2 * keystrokes;
+
+        coroutine_spawn(&test_co, "inputlat", inputlat_test_loop,
+                        &inputlat_test);
+    }
+    else
+    {
+        print_input_latency();
+    }
+}
+
+void init_inputlat()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = inputlat_command,
+        .name = "inputlat",
+        .name_len = 8,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,224 @@
+#include <histogram.h>
+#include <input.h>
+#include <metrics.h>
+#include <percpu.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sync.h>
+
+extern const metric_t __start_metrics[];
+extern const metric_t __stop_metrics[];
+
+void metric_histogram_add(histogram_t *histogram, uint64_t value)
+{
+    __atomic_add_fetch(&histogram->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->total, value, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->buckets[histogram_bucket(value)], 1,
+                       __ATOMIC_RELAXED);
+
+    uint32_t saturated = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+    uint32_t max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+
+    // on failure `max` is reloaded with the value stored by an interrupt
+    // handler in-between
+    while (saturated > max &&
+           !__atomic_compare_exchange_n(&histogram->max, &max, saturated, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static uint64_t counter_read(const metric_t *metric)
+{
+    const uint64_t *instances = metric->instances;
+    uint64_t sum = 0;
+
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        sum += __atomic_load_n(&instances[cpu], __ATOMIC_RELAXED);
+    }
+
+    return sum;
+}
+
+static int32_t gauge_read(const metric_t *metric)
+{
+    const int32_t *instances = metric->instances;
+    int32_t sum = 0;
+
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        sum += __atomic_load_n(&instances[cpu], __ATOMIC_RELAXED);
+    }
+
+    return sum;
+}
+
+static void histogram_read(const metric_t *metric, histogram_t *sum)
+{
+    const histogram_t *instances = metric->instances;
+
+    memset(sum, 0, sizeof(*sum));
+
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        const histogram_t *histogram = &instances[cpu];
+
+        sum->count += histogram->count;
+        sum->total += histogram->total;
+
+        if (histogram->max > sum->max)
+        {
+            sum->max = histogram->max;
+        }
+
+        for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+        {
+            sum->buckets[bucket] += histogram->buckets[bucket];
+        }
+    }
+}
+
+/// @brief Formats the value in decimal, `printf` only handles 32 bits
+/// @returns `buffer`
+static const char *format_u64(uint64_t value, char buffer[21])
+{
+    char *ptr = buffer + 20;
+    *ptr = '\0';
+
+    do
+    {
+        *--ptr = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    return ptr;
+}
+
+static void metric_print(const metric_t *metric)
+{
+    char buffer[21];
+
+    switch (metric->kind)
+    {
+    case METRIC_COUNTER:
+        printf("%s: %s\n", metric->name,
+               format_u64(counter_read(metric), buffer));
+        break;
+
+    case METRIC_GAUGE:
+        printf("%s: %d\n", metric->name, gauge_read(metric));
+        break;
+
+    case METRIC_HISTOGRAM:
+    {
+        histogram_t histogram;
+        histogram_read(metric, &histogram);
+
+        printf("%s: %u samples, avg %u, max %u, p99 ", metric->name,
+               histogram.count, histogram_average(&histogram), histogram.max);
+        histogram_print_bucket(histogram_percentile(&histogram, 99));
+        printf("\n");
+        break;
+    }
+    }
+}
+
+static void metric_reset(const metric_t *metric)
+{
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        switch (metric->kind)
+        {
+        case METRIC_COUNTER:
+            __atomic_store_n(&((uint64_t *)metric->instances)[cpu], 0,
+                             __ATOMIC_RELAXED);
+            break;
+
+        case METRIC_GAUGE:
+            // gauges track a current state, which a reset doesn't change
+            break;
+
+        case METRIC_HISTOGRAM:
+        {
+            // the fields are cleared one by one, keep interrupt handlers from
+            // updating the histogram halfway through
+            irq_flags_t flags = irq_save();
+            memset(&((histogram_t *)metric->instances)[cpu], 0,
+                   sizeof(histogram_t));
+            irq_restore(flags);
+            break;
+        }
+        }
+    }
+}
+
+static const metric_t *metric_find(const char *name)
+{
+    for (const metric_t *metric = __start_metrics; metric < __stop_metrics;
+         metric++)
+    {
+        if (strcmp(metric->name, name) == 0)
+        {
+            return metric;
+        }
+    }
+
+    return NULL;
+}
+
+/// @brief `stats [reset | <name>]`
+void stats_command(const char *args)
+{
+    if (strcmp(args, "reset") == 0)
+    {
+        for (const metric_t *metric = __start_metrics;
+             metric < __stop_metrics; metric++)
+        {
+            metric_reset(metric);
+        }
+
+        printf("metrics cleared\n");
+    }
+    else if (*args != '\0')
+    {
+        const metric_t *metric = metric_find(args);
+
+        if (!metric)
+        {
+            printf("no metric named '%s'\n", args);
+            return;
+        }
+
+        metric_print(metric);
+
+        if (metric->kind == METRIC_HISTOGRAM)
+        {
+            histogram_t histogram;
+            histogram_read(metric, &histogram);
+            histogram_print(&histogram, metric->name);
+        }
+    }
+    else
+    {
+        for (const metric_t *metric = __start_metrics;
+             metric < __stop_metrics; metric++)
+        {
+            metric_print(metric);
+        }
+    }
+}
+
+void init_stats()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = stats_command,
+        .name = "stats",
+        .name_len = 5,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,310 @@
+#include <input.h>
+#include <irq.h>
+#include <ksym.h>
+#include <percpu.h>
+#include <profile.h>
+#include <serial.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sync.h>
+
+/// A single-producer single-consumer ring. The producer is the timer interrupt,
+/// the consumer is `profile dump`.
+typedef struct
+{
+    uint32_t words[PROFILE_RING_WORDS];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+
+    uint32_t samples;
+    /// @brief Samples that didn't fit in the ring
+    volatile uint32_t dropped;
+} profile_ring_t;
+
+static DEFINE_PER_CPU(profile_ring_t, profile_rings);
+
+/// @brief The maximum amount of distinct functions `profile top` counts
+#define PROFILE_HOTSPOTS 128
+
+/// @brief The amount of functions `profile top` prints
+#define PROFILE_TOP 10
+
+static volatile bool profiling;
+static bool profile_handler_registered;
+
+/// @brief Fills `addresses` with the interrupted EIP and the return addresses
+///        of its callers
+/// @returns The amount of addresses
+static uint32_t profile_walk(const irq_frame_t *frame, uint32_t *addresses)
+{
+    uint32_t depth = 0;
+    uintptr_t ebp = frame->ebp;
+
+    addresses[depth++] = frame->eip;
+
+    while (depth < PROFILE_MAX_DEPTH && stack_frame_is_valid(ebp))
+    {
+        const uintptr_t *stack_frame = (const uintptr_t *)ebp;
+        uintptr_t return_address = stack_frame[1];
+
+        if (return_address == 0)
+        {
+            break;
+        }
+
+        addresses[depth++] = return_address;
+
+        // stacks grow down, so the callers' frames are at higher addresses
+        if (stack_frame[0] <= ebp)
+        {
+            break;
+        }
+
+        ebp = stack_frame[0];
+    }
+
+    return depth;
+}
+
+static bool profile_irq(void *ctx)
+{
+    (void)ctx;
+
+    irq_frame_t *frame = irq_get_regs();
+
+    if (!profiling || !frame)
+    {
+        return false;
+    }
+
+    profile_ring_t *ring = &this_cpu(profile_rings);
+    uint32_t addresses[PROFILE_MAX_DEPTH];
+    uint32_t depth = profile_walk(frame, addresses);
+
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (PROFILE_RING_WORDS - (head - tail) < depth + 1)
+    {
+        ring->dropped++;
+        return false;
+    }
+
+    ring->words[head++ & (PROFILE_RING_WORDS - 1)] = depth;
+
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        ring->words[head++ & (PROFILE_RING_WORDS - 1)] = addresses[i];
+    }
+
+    ring->samples++;
+
+    __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+
+    // the timer's own handler acknowledges the interrupt
+    return false;
+}
+
+static void serial_write_u32(uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        write_serial((char)(value >> (i * 8)));
+    }
+}
+
+static void serial_write_bytes(const char *bytes, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        write_serial(bytes[i]);
+    }
+}
+
+/// @brief Streams the buffered samples of the CPU over COM1 and removes them
+///        from the ring
+/// @returns The amount of streamed samples
+static uint32_t profile_dump(unsigned int cpu)
+{
+    profile_ring_t *ring = &per_cpu(profile_rings, cpu);
+
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+
+    uint32_t samples = 0;
+
+    for (uint32_t pos = tail; pos != head;
+         pos += 1 + ring->words[pos & (PROFILE_RING_WORDS - 1)])
+    {
+        samples++;
+    }
+
+    serial_write_bytes("PRF1", 4);
+    serial_write_u32(cpu);
+    serial_write_u32(samples);
+    serial_write_u32(dropped);
+
+    while (tail != head)
+    {
+        uint32_t depth = ring->words[tail++ & (PROFILE_RING_WORDS - 1)];
+
+        write_serial((char)depth);
+
+        for (uint32_t i = 0; i < depth; i++)
+        {
+            serial_write_u32(ring->words[tail++ & (PROFILE_RING_WORDS - 1)]);
+        }
+
+        // free the space as we go, so sampling can continue during the dump
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    serial_write_bytes("PEND", 4);
+
+    return samples;
+}
+
+typedef struct
+{
+    uintptr_t function;
+    uint32_t samples;
+} profile_hotspot_t;
+
+/// @brief Prints the functions that the buffered samples of this CPU were
+///        taken in most often, symbolized with the embedded symbol table
+static void profile_top(void)
+{
+    static profile_hotspot_t hotspots[PROFILE_HOTSPOTS];
+    uint32_t hotspot_count = 0;
+    uint32_t samples = 0;
+
+    memset(hotspots, 0, sizeof(hotspots));
+
+    profile_ring_t *ring = &this_cpu(profile_rings);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    for (uint32_t pos = ring->tail; pos != head;
+         pos += 1 + ring->words[pos & (PROFILE_RING_WORDS - 1)])
+    {
+        uintptr_t eip = ring->words[(pos + 1) & (PROFILE_RING_WORDS - 1)];
+        uint32_t offset = 0;
+
+        if (ksym_lookup(eip, &offset))
+        {
+            eip -= offset;
+        }
+
+        samples++;
+
+        uint32_t i = 0;
+
+        while (i < hotspot_count && hotspots[i].function != eip)
+        {
+            i++;
+        }
+
+        if (i == PROFILE_HOTSPOTS)
+        {
+            continue;
+        }
+
+        hotspots[i].function = eip;
+        hotspots[i].samples++;
+
+        if (i == hotspot_count)
+        {
+            hotspot_count++;
+        }
+    }
+
+    printf("%u buffered samples\n", samples);
+
+    for (int rank = 0; rank < PROFILE_TOP; rank++)
+    {
+        profile_hotspot_t *best = NULL;
+
+        for (uint32_t i = 0; i < hotspot_count; i++)
+        {
+            if (hotspots[i].samples == 0)
+            {
+                continue;
+            }
+
+            if (!best || hotspots[i].samples > best->samples)
+            {
+                best = &hotspots[i];
+            }
+        }
+
+        if (!best)
+        {
+            break;
+        }
+
+        printf("%u%%  ", best->samples * 100 / samples);
+        ksym_print(best->function);
+        printf("\n");
+
+        best->samples = 0;
+    }
+}
+
+/// @brief `profile start|stop|dump|top`
+void profile_command(const char *args)
+{
+    if (strcmp(args, "start") == 0)
+    {
+        if (!profile_handler_registered)
+        {
+            profile_handler_registered =
+                irq_register(IRQ_VECTOR(0), profile_irq, NULL);
+        }
+
+        profiling = true;
+        printf("profiling started\n");
+    }
+    else if (strcmp(args, "stop") == 0)
+    {
+        profiling = false;
+        printf("profiling stopped\n");
+    }
+    else if (strcmp(args, "top") == 0)
+    {
+        profile_top();
+    }
+    else if (strcmp(args, "dump") == 0)
+    {
+        uint32_t samples = 0;
+
+        for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+        {
+            samples += profile_dump(cpu);
+        }
+
+        printf("\n%u samples written to the serial line\n", samples);
+    }
+    else
+    {
+        profile_ring_t *ring = &this_cpu(profile_rings);
+
+        printf("profiler %s, %u samples taken, %u buffered words, %u dropped\n",
+               profiling ? "running" : "stopped", ring->samples,
+               ring->head - ring->tail, ring->dropped);
+        printf("usage: profile start|stop|dump|top\n");
+    }
+}
+
+void init_profile()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = profile_command,
+        .name = "profile",
+        .name_len = 7,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,369 @@
+#include <cpuid.h>
+#include <input.h>
+#include <percpu.h>
+#include <random.h>
+#include <serial.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sync.h>
+#include <timer.h>
+#include <trace.h>
+
+/// @brief The amount of records each CPU's ring holds. Must be a power of two.
+#define TRACE_RING_RECORDS 4096
+
+#define TRACE_JMP_OPCODE 0xe9
+#define TRACE_SITE_SIZE 5
+
+static const uint8_t trace_nop[TRACE_SITE_SIZE] = {0x0f, 0x1f, 0x44, 0x00,
+                                                   0x00};
+
+#define TRACEPOINT_DEFINE(tp_name, tp_kind)                                    \
+    tracepoint_t __tracepoint_##tp_name = {                                    \
+        .name = #tp_name,                                                      \
+        .id = TRACE_ID_##tp_name,                                              \
+        .kind = tp_kind,                                                       \
+        .enabled = false,                                                      \
+    };
+
+TRACEPOINT_LIST(TRACEPOINT_DEFINE)
+
+#undef TRACEPOINT_DEFINE
+
+#define TRACEPOINT_ENTRY(tp_name, tp_kind) &__tracepoint_##tp_name,
+
+static tracepoint_t *const tracepoints[TRACEPOINT_COUNT] = {
+    TRACEPOINT_LIST(TRACEPOINT_ENTRY)};
+
+#undef TRACEPOINT_ENTRY
+
+/// @brief An entry emitted into `__jump_table` by `tracepoint_enabled`
+typedef struct
+{
+    uintptr_t site;
+    uintptr_t target;
+    tracepoint_t *tracepoint;
+} jump_entry_t;
+
+extern jump_entry_t __start_jump_table[];
+extern jump_entry_t __stop_jump_table[];
+
+typedef struct
+{
+    trace_record_t record;
+    /// @brief One past the position the record was written at, once the
+    ///        record is complete
+    volatile uint32_t committed;
+} trace_slot_t;
+
+/// A multi-producer single-consumer ring. Any code on the CPU can be a
+/// producer, including interrupt handlers that preempt another producer
+/// halfway through a record, so the slots are reserved with a CAS and marked
+/// as complete separately. The consumer is `trace dump`, it stops at the first
+/// slot that isn't complete yet.
+typedef struct
+{
+    trace_slot_t slots[TRACE_RING_RECORDS];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+
+    /// @brief Records that didn't fit in the ring
+    volatile uint32_t dropped;
+} trace_ring_t;
+
+static DEFINE_PER_CPU(trace_ring_t, trace_rings);
+
+void trace_record(tracepoint_t *tracepoint, uint32_t arg)
+{
+    trace_ring_t *ring = &this_cpu(trace_rings);
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+    do
+    {
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+        if (head - tail >= TRACE_RING_RECORDS)
+        {
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, head + 1, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    trace_slot_t *slot = &ring->slots[head & (TRACE_RING_RECORDS - 1)];
+
+    slot->record.timestamp = rdtsc();
+    slot->record.arg = arg;
+    slot->record.id = tracepoint->id;
+    slot->record.cpu = cpu_id();
+
+    __atomic_store_n(&slot->committed, head + 1, __ATOMIC_RELEASE);
+}
+
+/// @brief Writes the instruction at the tracepoint site: a jump to the
+///        recording code, or the NOP that falls through past it
+static void trace_patch_site(const jump_entry_t *entry, bool enabled)
+{
+    volatile uint8_t *site = (volatile uint8_t *)entry->site;
+
+    if (enabled)
+    {
+        uint32_t offset = entry->target - (entry->site + TRACE_SITE_SIZE);
+
+        site[0] = TRACE_JMP_OPCODE;
+
+        for (int i = 0; i < 4; i++)
+        {
+            site[1 + i] = (uint8_t)(offset >> (i * 8));
+        }
+    }
+    else
+    {
+        for (int i = 0; i < TRACE_SITE_SIZE; i++)
+        {
+            site[i] = trace_nop[i];
+        }
+    }
+}
+
+void tracepoint_set(tracepoint_t *tracepoint, bool enabled)
+{
+    // a site is a single instruction, so nothing on this CPU can be executing
+    // it halfway while interrupts are off
+    irq_flags_t flags = irq_save();
+
+    for (jump_entry_t *entry = __start_jump_table; entry < __stop_jump_table;
+         entry++)
+    {
+        if (entry->tracepoint == tracepoint)
+        {
+            trace_patch_site(entry, enabled);
+        }
+    }
+
+    tracepoint->enabled = enabled;
+
+    // serializes the instruction stream, so the patched sites are refetched
+    cpuid(0);
+
+    irq_restore(flags);
+}
+
+/// @brief Whether `name` selects the tracepoint: its full name, the name of
+///        the span it begins or ends, or `all`
+static bool trace_matches(const tracepoint_t *tracepoint, const char *name)
+{
+    if (strcmp(name, "all") == 0 || strcmp(name, tracepoint->name) == 0)
+    {
+        return true;
+    }
+
+    if (tracepoint->kind == TRACE_INSTANT)
+    {
+        return false;
+    }
+
+    size_t length = strlen(name);
+
+    if (memcmp(name, tracepoint->name, length) != 0)
+    {
+        return false;
+    }
+
+    const char *suffix = tracepoint->name + length;
+
+    return strcmp(suffix, "_entry") == 0 || strcmp(suffix, "_exit") == 0;
+}
+
+static void trace_set(const char *name, bool enabled)
+{
+    int matched = 0;
+
+    for (int i = 0; i < TRACEPOINT_COUNT; i++)
+    {
+        if (trace_matches(tracepoints[i], name))
+        {
+            tracepoint_set(tracepoints[i], enabled);
+            matched++;
+        }
+    }
+
+    if (matched == 0)
+    {
+        printf("no tracepoint named '%s'\n", name);
+        return;
+    }
+
+    printf("%d tracepoint(s) %s\n", matched, enabled ? "enabled" : "disabled");
+}
+
+/// @brief Returns the amount of complete records in the ring, starting from
+///        its tail
+static uint32_t trace_complete_records(trace_ring_t *ring)
+{
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t pos = tail;
+
+    while (pos != head)
+    {
+        trace_slot_t *slot = &ring->slots[pos & (TRACE_RING_RECORDS - 1)];
+
+        if (__atomic_load_n(&slot->committed, __ATOMIC_ACQUIRE) != pos + 1)
+        {
+            break;
+        }
+
+        pos++;
+    }
+
+    return pos - tail;
+}
+
+static void serial_write_u32(uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        write_serial((char)(value >> (i * 8)));
+    }
+}
+
+static void serial_write_bytes(const char *bytes, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        write_serial(bytes[i]);
+    }
+}
+
+/// @brief Streams the complete records of the CPU over COM1, together with the
+///        tracepoint names and the TSC frequency, and removes them from the ring
+/// @returns The amount of streamed records
+static uint32_t trace_dump(unsigned int cpu)
+{
+    trace_ring_t *ring = &per_cpu(trace_rings, cpu);
+
+    uint32_t records = trace_complete_records(ring);
+    uint32_t dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+
+    serial_write_bytes("TRC1", 4);
+    serial_write_u32(cpu);
+    serial_write_u32(timer_tsc_khz());
+    serial_write_u32(TRACEPOINT_COUNT);
+
+    for (int i = 0; i < TRACEPOINT_COUNT; i++)
+    {
+        size_t length = strlen(tracepoints[i]->name);
+
+        write_serial((char)tracepoints[i]->kind);
+        write_serial((char)length);
+        serial_write_bytes(tracepoints[i]->name, length);
+    }
+
+    serial_write_u32(records);
+    serial_write_u32(dropped);
+
+    uint32_t tail = ring->tail;
+
+    for (uint32_t i = 0; i < records; i++)
+    {
+        trace_slot_t *slot = &ring->slots[tail++ & (TRACE_RING_RECORDS - 1)];
+
+        serial_write_bytes((const char *)&slot->record, sizeof(slot->record));
+
+        // free the space as we go, so tracing can continue during the dump
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    serial_write_bytes("TEND", 4);
+
+    return records;
+}
+
+static void trace_clear(void)
+{
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        trace_ring_t *ring = &per_cpu(trace_rings, cpu);
+
+        uint32_t tail = ring->tail;
+        ring->tail = tail + trace_complete_records(ring);
+        ring->dropped = 0;
+    }
+}
+
+static void trace_list(void)
+{
+    trace_ring_t *ring = &this_cpu(trace_rings);
+
+    for (int i = 0; i < TRACEPOINT_COUNT; i++)
+    {
+        int sites = 0;
+
+        for (jump_entry_t *entry = __start_jump_table;
+             entry < __stop_jump_table; entry++)
+        {
+            if (entry->tracepoint == tracepoints[i])
+            {
+                sites++;
+            }
+        }
+
+        printf("%s %s (%d sites)\n", tracepoints[i]->enabled ? "on " : "off",
+               tracepoints[i]->name, sites);
+    }
+
+    printf("%u buffered records, %u dropped\n", ring->head - ring->tail,
+           ring->dropped);
+    printf("usage: trace on|off <name|all> / dump / clear\n");
+}
+
+/// @brief `trace [on <name|all>|off <name|all>|dump|clear]`
+void trace_command(const char *args)
+{
+    if (memcmp(args, "on ", 3) == 0)
+    {
+        trace_set(args + 3, true);
+    }
+    else if (memcmp(args, "off ", 4) == 0)
+    {
+        trace_set(args + 4, false);
+    }
+    else if (strcmp(args, "dump") == 0)
+    {
+        // calibrate before the dump, so it doesn't stall the stream halfway
+        timer_tsc_khz();
+
+        uint32_t records = 0;
+
+        for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+        {
+            records += trace_dump(cpu);
+        }
+
+        printf("\n%u records written to the serial line\n", records);
+    }
+    else if (strcmp(args, "clear") == 0)
+    {
+        trace_clear();
+        printf("trace buffer cleared\n");
+    }
+    else
+    {
+        trace_list();
+    }
+}
+
+void init_trace()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = trace_command,
+        .name = "trace",
+        .name_len = 5,
+    };
+
+    add_command(cmd);
+}
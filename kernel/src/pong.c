@@ -1,11 +1,18 @@
+#include <bench.h>
+#include <fixed.h>
+#include <game.h>
+#include <metrics.h>
 #include <random.h>
+#include <replay.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <timer.h>
 #include <tty.h>
 
 #define PADDLE_HEIGHT 5
 
-#define BALL_SPEED 1.0
+#define BALL_SPEED FIXED_ONE
 
 #define FRAME_START_X 0
 #define FRAME_START_Y 0
@@ -16,14 +23,16 @@
 #define FRAME_END_X (FRAME_START_X + FRAME_SIZE_X - 1)
 #define FRAME_END_Y (FRAME_START_Y + FRAME_SIZE_Y - 1)
 
-#define WALL_TOP ((float)FRAME_START_Y + 1.0f)
-#define WALL_BOTTOM ((float)FRAME_END_Y - 1.0f)
-#define LEFT_BOUND ((float)FRAME_START_X + 2.0f)
-#define RIGHT_BOUND ((float)FRAME_END_X - 2.0f)
+#define WALL_TOP FIXED_INT(FRAME_START_Y + 1)
+#define WALL_BOTTOM FIXED_INT(FRAME_END_Y - 1)
+#define LEFT_BOUND FIXED_INT(FRAME_START_X + 2)
+#define RIGHT_BOUND FIXED_INT(FRAME_END_X - 2)
 
-#define FRAME_CENTER fvec2((float)FRAME_SIZE_X / 2.0, (float)FRAME_SIZE_Y / 2.0)
+#define FRAME_CENTER                                                           \
+    fvec2(FIXED_RATIO(FRAME_SIZE_X, 2), FIXED_RATIO(FRAME_SIZE_Y, 2))
 
-#define CYCLES 100000000
+/// @brief The length of a step, every step moves the ball by `BALL_SPEED`
+#define PONG_STEP_US 40000
 
 typedef struct
 {
@@ -37,13 +46,14 @@ static inline ivec2_t ivec2(int x, int y)
     return v;
 }
 
+/// @brief A vector of fixed-point numbers, see `fixed.h`
 typedef struct
 {
-    float x;
-    float y;
+    fixed_t x;
+    fixed_t y;
 } fvec2_t;
 
-static inline fvec2_t fvec2(float x, float y)
+static inline fvec2_t fvec2(fixed_t x, fixed_t y)
 {
     fvec2_t v = {x, y};
     return v;
@@ -51,7 +61,7 @@ static inline fvec2_t fvec2(float x, float y)
 
 static inline ivec2_t quantize_from_fvec2(fvec2_t vec)
 {
-    return ivec2((int)vec.x, (int)vec.y);
+    return ivec2(fixed_to_int(vec.x), fixed_to_int(vec.y));
 }
 
 typedef struct
@@ -74,13 +84,11 @@ typedef struct
     paddle_t left_paddle;
     paddle_t right_paddle;
     ball_t ball;
-    uint64_t time;
-    bool should_stop;
 } pong_game_t;
 
 tty_t pong_tty;
 
-static inline bool inside(float y, float top, float bottom)
+static inline bool inside(fixed_t y, fixed_t top, fixed_t bottom)
 {
     return y >= top && y <= bottom;
 }
@@ -91,27 +99,23 @@ void reset_ball(pong_game_t *game)
 
     bool goesRight = rand() % 2 == 0;
 
-    ball->velocity = fvec2(goesRight ? BALL_SPEED : -BALL_SPEED, 0.0);
+    ball->velocity = fvec2(goesRight ? BALL_SPEED : -BALL_SPEED, 0);
     ball->position = FRAME_CENTER;
     ball->isPaused = true;
 }
 
-float clamp(float val, float min, float max)
+/// @brief Moves the paddle by its velocity, keeping it inside the frame
+static void move_paddle(paddle_t *paddle)
 {
-    if (val >= max)
-    {
-        return max;
-    }
-
-    if (val <= min)
-    {
-        return min;
-    }
+    fixed_t position =
+        fixed_from_int(paddle->verticalPosition + paddle->velocity);
 
-    return val;
+    paddle->verticalPosition = fixed_to_int(fixed_clamp(
+        position, FIXED_INT(1), FIXED_INT(FRAME_END_Y - PADDLE_HEIGHT)));
 }
 
-void update_game(pong_game_t *game, float dt)
+/// @brief Advances the game by `dt` frames
+void update_game(pong_game_t *game, fixed_t dt)
 {
     ball_t *ball = &game->ball;
     paddle_t *left_paddle = &game->left_paddle;
@@ -122,29 +126,32 @@ void update_game(pong_game_t *game, float dt)
         return;
     }
 
-    ball->position = fvec2(ball->position.x + ball->velocity.x * dt,
-                           ball->position.y + ball->velocity.y * dt);
+    ball->position = fvec2(
+        fixed_add_sat(ball->position.x, fixed_mul_sat(ball->velocity.x, dt)),
+        fixed_add_sat(ball->position.y, fixed_mul_sat(ball->velocity.y, dt)));
 
     if (ball->position.y <= WALL_TOP)
     {
         ball->position.y = WALL_TOP;
-        ball->velocity.y = 1.0;
+        ball->velocity.y = FIXED_ONE;
     }
 
     if (ball->position.y >= WALL_BOTTOM)
     {
         ball->position.y = WALL_BOTTOM;
-        ball->velocity.y = -1.0;
+        ball->velocity.y = -FIXED_ONE;
     }
 
     if (ball->position.x <= LEFT_BOUND)
     {
-        if (inside(ball->position.y, left_paddle->verticalPosition,
-                   left_paddle->verticalPosition + PADDLE_HEIGHT))
+        int top = left_paddle->verticalPosition;
+
+        if (inside(ball->position.y, fixed_from_int(top),
+                   fixed_from_int(top + PADDLE_HEIGHT)))
         {
             ball->position.x = LEFT_BOUND;
             ball->velocity.x = BALL_SPEED;
-            ball->velocity.y = (float)left_paddle->velocity;
+            ball->velocity.y = fixed_from_int(left_paddle->velocity);
         }
         else
         {
@@ -154,12 +161,14 @@ void update_game(pong_game_t *game, float dt)
 
     if (ball->position.x >= RIGHT_BOUND)
     {
-        if (inside(ball->position.y, right_paddle->verticalPosition,
-                   right_paddle->verticalPosition + PADDLE_HEIGHT))
+        int top = right_paddle->verticalPosition;
+
+        if (inside(ball->position.y, fixed_from_int(top),
+                   fixed_from_int(top + PADDLE_HEIGHT)))
         {
             ball->position.x = RIGHT_BOUND;
             ball->velocity.x = -BALL_SPEED;
-            ball->velocity.y = (float)right_paddle->velocity;
+            ball->velocity.y = fixed_from_int(right_paddle->velocity);
         }
         else
         {
@@ -167,62 +176,17 @@ void update_game(pong_game_t *game, float dt)
         }
     }
 
-    left_paddle->verticalPosition =
-        clamp(left_paddle->velocity + left_paddle->verticalPosition, 1,
-              FRAME_END_Y - PADDLE_HEIGHT);
-    right_paddle->verticalPosition =
-        clamp(right_paddle->velocity + right_paddle->verticalPosition, 1,
-              FRAME_END_Y - PADDLE_HEIGHT);
+    move_paddle(left_paddle);
+    move_paddle(right_paddle);
 }
 
-void pong_input_handler(keys_t key, bool was_pressed, void *data)
+/// @brief Moves the paddles for as long as their keys are held
+void update_paddle_velocities(pong_game_t *game, const game_input_t *input)
 {
-    pong_game_t *game = (pong_game_t *)data;
-
-    if (!was_pressed)
-    {
-        switch (key)
-        {
-        case KB_S:
-        case KB_W:
-            game->left_paddle.velocity = 0;
-            break;
-        case KB_Arrow_Down:
-        case KB_Arrow_Up:
-            game->right_paddle.velocity = 0;
-            break;
-
-        default:
-            break;
-        }
-
-        return;
-    }
-
-    switch (key)
-    {
-    case KB_Space:
-        game->ball.isPaused = false;
-        return;
-    case KB_S:
-        game->left_paddle.velocity = 1;
-        return;
-    case KB_W:
-        game->left_paddle.velocity = -1;
-        return;
-    case KB_Arrow_Down:
-        game->right_paddle.velocity = 1;
-        return;
-    case KB_Arrow_Up:
-        game->right_paddle.velocity = -1;
-        return;
-    case KB_Q:
-    case KB_Esc:
-        game->should_stop = true;
-        return;
-    default:
-        return;
-    }
+    game->left_paddle.velocity =
+        game_key_held(input, KB_S) - game_key_held(input, KB_W);
+    game->right_paddle.velocity = game_key_held(input, KB_Arrow_Down) -
+                                  game_key_held(input, KB_Arrow_Up);
 }
 
 pong_game_t create_game()
@@ -247,119 +211,271 @@ pong_game_t create_game()
 
     game.right_paddle = right_paddle;
 
-    game.time = rdtsc();
-
     reset_ball(&game);
 
     return game;
 }
 
-void draw_frame()
+void draw_frame(game_canvas_t *canvas)
 {
     terminal_entry_color_t color = {
         .background = TTY_COLOR_BLACK,
         .foreground = TTY_COLOR_DARK_GREY,
     };
 
-    tty_set_color(&pong_tty, color);
-
     // bottom and top frame
     for (int x = 0; x < FRAME_SIZE_X; x++)
     {
-        tty_set_char_at(&pong_tty, '#', x, 0);
-        tty_set_char_at(&pong_tty, '#', x, FRAME_END_Y);
+        game_canvas_put(canvas, x, 0, '#', color);
+        game_canvas_put(canvas, x, FRAME_END_Y, '#', color);
     }
 
     // left and right frame
     for (int y = 0; y < FRAME_SIZE_Y; y++)
     {
-        tty_set_char_at(&pong_tty, '#', 0, y);
-        tty_set_char_at(&pong_tty, '#', FRAME_END_X, y);
+        game_canvas_put(canvas, 0, y, '#', color);
+        game_canvas_put(canvas, FRAME_END_X, y, '#', color);
     }
 }
 
-void draw_ball(ball_t *ball)
+void draw_ball(ball_t *ball, game_canvas_t *canvas)
 {
-    terminal_entry_t entry = {
-        .character = 'o',
-        .color =
-            {
-                .background = TTY_COLOR_BLACK,
-                .foreground = TTY_COLOR_WHITE,
-            },
+    terminal_entry_color_t color = {
+        .background = TTY_COLOR_BLACK,
+        .foreground = TTY_COLOR_WHITE,
     };
 
     ivec2_t pos = quantize_from_fvec2(ball->position);
-    tty_set_entry_at(&pong_tty, entry, pos.x, pos.y);
+    game_canvas_put(canvas, pos.x, pos.y, 'o', color);
 }
 
-void draw_paddle(paddle_t *paddle)
+void draw_paddle(paddle_t *paddle, game_canvas_t *canvas)
 {
     terminal_entry_color_t color = {
         .background = TTY_COLOR_BLACK,
         .foreground = paddle->isLeft ? TTY_COLOR_BLUE : TTY_COLOR_RED,
     };
 
-    tty_set_color(&pong_tty, color);
-
     int horizontal_pos = paddle->isLeft ? FRAME_START_X + 2 : FRAME_END_X - 2;
 
     for (int y = 0; y < PADDLE_HEIGHT; y++)
     {
-        tty_set_char_at(&pong_tty, '@', horizontal_pos,
-                        y + paddle->verticalPosition);
+        game_canvas_put(canvas, horizontal_pos, y + paddle->verticalPosition,
+                        '@', color);
     }
 }
 
-void run_pong()
+static pong_game_t pong_game;
+static game_runtime_t pong_runtime;
+
+/// @brief The updates the game ran
+DEFINE_COUNTER(pong_steps);
+
+static bool pong_update(void *state, const game_input_t *input)
+{
+    pong_game_t *game = (pong_game_t *)state;
+
+    if (game_key_pressed(input, KB_Q) || game_key_pressed(input, KB_Esc))
+    {
+        return false;
+    }
+
+    if (game_key_pressed(input, KB_Space))
+    {
+        game->ball.isPaused = false;
+    }
+
+    counter_inc(pong_steps);
+
+    update_paddle_velocities(game, input);
+    update_game(game, FIXED_ONE);
+
+    return true;
+}
+
+static void pong_render(void *state, game_canvas_t *canvas)
 {
-    pong_game_t game = create_game();
+    pong_game_t *game = (pong_game_t *)state;
+    terminal_entry_color_t blank = {
+        .background = TTY_COLOR_BLACK,
+        .foreground = TTY_COLOR_WHITE,
+    };
+
+    // only the cells that differ from the last frame reach the tty
+    game_canvas_fill(canvas, ' ', blank);
+
+    draw_frame(canvas);
+    draw_ball(&game->ball, canvas);
+    draw_paddle(&game->left_paddle, canvas);
+    draw_paddle(&game->right_paddle, canvas);
+}
+
+static const game_t pong = {
+    .name = "pong",
+    .step_us = PONG_STEP_US,
+    .update = pong_update,
+    .render = pong_render,
+};
+
+/// The headless simulation plays without drawing anything or reading the
+/// keyboard: the paddles follow the ball most of the time, and every update
+/// advances the game by a random fraction of a frame. It only depends on the
+/// seed, so its trajectory is the same on every run.
+
+/// @brief The amount of updates `pong check` runs by default
+#define PONG_CHECK_UPDATES 100000
 
-    // the pointer to the game will not be used after this function quits
-    // because we set the active tty back to the kernel tty
-    tty_set_keypress_callback(&pong_tty, pong_input_handler, &game);
-    pong_tty.cursor_visible = false;
+/// @brief The seed of the simulation
+#define PONG_CHECK_SEED 0x90A6
 
-    tty_initialize(&pong_tty);
-    set_active_tty(&pong_tty);
+/// @brief The trajectory of `PONG_CHECK_UPDATES` updates from the seed
+#define PONG_CHECK_TRAJECTORY 0x99061288
 
-    srand((uint32_t)rdtsc());
+static pong_game_t pong_sim_game;
 
-    uint64_t last_frame_time = rdtsc();
+static void pong_sim_reset(void)
+{
+    srand(PONG_CHECK_SEED);
+
+    pong_sim_game = create_game();
+    pong_sim_game.ball.isPaused = false;
+}
 
-    while (!game.should_stop)
+static void pong_sim_move_paddle(paddle_t *paddle, ball_t *ball)
+{
+    bool ball_approaches = paddle->isLeft == (ball->velocity.x < 0);
+    int ball_y = fixed_to_int(ball->position.y);
+    int center = paddle->verticalPosition + PADDLE_HEIGHT / 2;
+
+    if (!ball_approaches || rand() % 4 == 0)
     {
-        uint64_t time = rdtsc();
+        paddle->velocity = 0;
+        return;
+    }
 
-        if (time - last_frame_time < CYCLES)
-        {
-            continue;
-        }
+    paddle->velocity = (ball_y > center) - (ball_y < center);
+}
+
+static void pong_sim_update(pong_game_t *game)
+{
+    pong_sim_move_paddle(&game->left_paddle, &game->ball);
+    pong_sim_move_paddle(&game->right_paddle, &game->ball);
+
+    fixed_t dt = FIXED_RATIO(1, 2) + (fixed_t)(rand() % FIXED_ONE);
+
+    update_game(game, dt);
+
+    // serves the ball right away after a miss
+    game->ball.isPaused = false;
+}
+
+/// @brief Mixes the positions and velocities into the hash, FNV-1a style
+static uint32_t pong_sim_hash(uint32_t hash, const pong_game_t *game)
+{
+    const int32_t values[] = {
+        game->ball.position.x,           game->ball.position.y,
+        game->ball.velocity.x,           game->ball.velocity.y,
+        game->left_paddle.verticalPosition,
+        game->right_paddle.verticalPosition,
+    };
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        hash = (hash ^ (uint32_t)values[i]) * 16777619;
+    }
+
+    return hash;
+}
+
+/// @brief Runs the simulation from the seed and returns its trajectory's hash
+static uint32_t pong_sim_run(uint32_t updates)
+{
+    uint32_t hash = 2166136261;
+
+    pong_sim_reset();
+
+    for (uint32_t i = 0; i < updates; i++)
+    {
+        pong_sim_update(&pong_sim_game);
+        hash = pong_sim_hash(hash, &pong_sim_game);
+    }
+
+    return hash;
+}
+
+/// @brief `pong check [updates]`, runs the simulation twice and compares the
+///        trajectories, with each other and with `PONG_CHECK_TRAJECTORY`
+static void pong_check_command(const char *args)
+{
+    uint32_t updates = *args ? (uint32_t)atoi(args) : PONG_CHECK_UPDATES;
+
+    uint64_t start = rdtsc();
+    uint32_t first = pong_sim_run(updates);
+    uint64_t cycles = rdtsc() - start;
+    uint32_t second = pong_sim_run(updates);
+
+    bool deterministic = first == second;
+
+    if (updates == PONG_CHECK_UPDATES)
+    {
+        deterministic = deterministic && first == PONG_CHECK_TRAJECTORY;
+    }
 
-        uint64_t elapsed = time - last_frame_time;
-        float dt = (float)(elapsed) / (float)CYCLES;
+    printf("trajectories %x and %x: %s\n", first, second,
+           deterministic ? "deterministic" : "MISMATCH");
 
-        last_frame_time = time;
+    uint64_t per_second =
+        cycles ? (uint64_t)updates * timer_tsc_khz() * 1000 / cycles : 0;
 
-        tty_clear(&pong_tty, TTY_COLOR_BLACK);
+    printf("%u cycles per update, %u updates/s\n",
+           (uint32_t)(updates ? cycles / updates : 0), (uint32_t)per_second);
+}
 
-        update_game(&game, dt);
+static void bench_pong_update(void)
+{
+    pong_sim_update(&pong_sim_game);
+}
 
-        draw_frame();
-        draw_ball(&game.ball);
-        draw_paddle(&game.left_paddle);
-        draw_paddle(&game.right_paddle);
+DEFINE_BENCH(pong_update, .setup = pong_sim_reset, .run = bench_pong_update);
 
-        tty_flush(&pong_tty);
+void run_pong()
+{
+    if (game_is_running(&pong_runtime))
+    {
+        return;
     }
 
-    set_active_tty(&kernel_tty);
+    srand(replay_seed());
+
+    pong_game = create_game();
+
+    game_start(&pong_runtime, &pong, &pong_game, &pong_tty);
+}
+
+/// @brief `pong [check [updates]]`
+void pong_command(const char *args)
+{
+    if (memcmp(args, "check", 5) == 0 && (args[5] == '\0' || args[5] == ' '))
+    {
+        args += 5;
+
+        while (*args == ' ')
+        {
+            args++;
+        }
+
+        pong_check_command(args);
+    }
+    else
+    {
+        run_pong();
+    }
 }
 
 void init_pong()
 {
     scratchpad_cmd_t cmd = {
-        .callback = run_pong,
+        .callback = pong_command,
         .name = "pong",
         .name_len = 4,
     };
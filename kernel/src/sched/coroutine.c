@@ -0,0 +1,255 @@
+#include <coroutine.h>
+#include <fpu.h>
+#include <hal.h>
+#include <input.h>
+#include <irqsoff.h>
+#include <metrics.h>
+#include <random.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sync.h>
+
+/// All the spawned coroutines. New coroutines are pushed to the front, which
+/// is a single pointer store, so spawning is safe from interrupt handlers.
+static coroutine_t *coroutines;
+
+/// @brief The amount of coroutines in the scheduler's list
+DEFINE_GAUGE(coroutines_linked);
+
+/// @brief Returns whether the coroutine is in the scheduler's list, which is
+///        also the case for finished coroutines that were not removed yet
+static bool coroutine_is_linked(coroutine_t *co)
+{
+    for (coroutine_t *it = coroutines; it; it = it->next)
+    {
+        if (it == co)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void coroutine_spawn(coroutine_t *co, const char *name, coroutine_fn_t fn,
+                     void *data)
+{
+    bool linked = coroutine_is_linked(co);
+
+    // a finished coroutine may be spawned again before it was reaped
+    if (linked)
+    {
+        fpu_release(&co->fpu);
+    }
+    else
+    {
+        co->fpu = NULL;
+    }
+
+    co->fn = fn;
+    co->data = data;
+    co->name = name;
+    co->resume_line = 0;
+    co->state = CO_READY;
+    co->wake_time = 0;
+    co->event = NULL;
+    co->resumes = 0;
+    co->cycles = 0;
+
+    if (!linked)
+    {
+        co->next = coroutines;
+        coroutines = co;
+        gauge_add(coroutines_linked, 1);
+    }
+}
+
+bool coroutine_is_running(coroutine_t *co)
+{
+    return coroutine_is_linked(co) && co->state != CO_DONE;
+}
+
+void co_event_signal(co_event_t *event)
+{
+    __atomic_add_fetch(&event->pending, 1, __ATOMIC_RELEASE);
+}
+
+bool co_event_try_consume(co_event_t *event)
+{
+    uint32_t pending = __atomic_load_n(&event->pending, __ATOMIC_ACQUIRE);
+
+    while (pending != 0)
+    {
+        if (__atomic_compare_exchange_n(&event->pending, &pending, pending - 1,
+                                        false, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_ACQUIRE))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// @brief Moves the coroutine to the ready state if whatever it waits on has
+///        happened
+static bool coroutine_update_ready(coroutine_t *co, uint64_t now)
+{
+    switch (co->state)
+    {
+    case CO_READY:
+        return true;
+    case CO_SLEEPING:
+        if (now >= co->wake_time)
+        {
+            co->state = CO_READY;
+        }
+        break;
+    case CO_WAITING:
+        if (co->event->pending != 0)
+        {
+            co->state = CO_READY;
+        }
+        break;
+    case CO_DONE:
+        break;
+    }
+
+    return co->state == CO_READY;
+}
+
+/// @brief Removes the finished coroutines from the scheduler
+static void coroutines_reap(void)
+{
+    // an interrupt handler may push a new coroutine to the front of the list
+    // while we're unlinking the first one
+    irq_flags_t flags = irq_save();
+
+    coroutine_t **link = &coroutines;
+
+    while (*link)
+    {
+        if ((*link)->state == CO_DONE)
+        {
+            fpu_release(&(*link)->fpu);
+            *link = (*link)->next;
+            gauge_add(coroutines_linked, -1);
+        }
+        else
+        {
+            link = &(*link)->next;
+        }
+    }
+
+    irq_restore(flags);
+}
+
+bool coroutines_run(void)
+{
+    bool any_resumed = false;
+    bool any_finished = false;
+
+    for (coroutine_t *co = coroutines; co; co = co->next)
+    {
+        uint64_t start = rdtsc();
+
+        if (!coroutine_update_ready(co, start))
+        {
+            any_finished |= co->state == CO_DONE;
+            continue;
+        }
+
+        fpu_switch(&co->fpu);
+        co->fn(co);
+
+        co->resumes++;
+        co->cycles += rdtsc() - start;
+
+        any_resumed = true;
+        any_finished |= co->state == CO_DONE;
+    }
+
+    fpu_switch(NULL);
+
+    if (any_finished)
+    {
+        coroutines_reap();
+    }
+
+    return any_resumed;
+}
+
+/// @brief Returns whether any coroutine could be resumed right now
+static bool coroutines_any_ready(void)
+{
+    uint64_t now = rdtsc();
+
+    for (coroutine_t *co = coroutines; co; co = co->next)
+    {
+        if (coroutine_update_ready(co, now))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+__attribute__((__noreturn__)) void scheduler_loop(void)
+{
+    while (1)
+    {
+        if (coroutines_run())
+        {
+            continue;
+        }
+
+        // Interrupts must stay disabled between the last check and `hlt`,
+        // otherwise an event signalled in-between would only be noticed on the
+        // next interrupt. `sti` only takes effect after the next instruction,
+        // so `sti; hlt` cannot miss an interrupt.
+        irq_flags_t flags = irq_save();
+
+        if (coroutines_any_ready())
+        {
+            irq_restore(flags);
+        }
+        else
+        {
+            // waiting for an interrupt isn't time spent with interrupts off
+            irqsoff_end();
+            hal_sti_hlt();
+        }
+    }
+}
+
+void print_coroutines()
+{
+    printf("name        state  resumes  cycles/resume\n");
+
+    static const char *state_names[] = {"ready", "sleep", "wait", "done"};
+
+    for (coroutine_t *co = coroutines; co; co = co->next)
+    {
+        uint32_t per_resume =
+            co->resumes ? (uint32_t)(co->cycles / co->resumes) : 0;
+
+        printf("%s  %s  %d  %d\n", co->name, state_names[co->state],
+               co->resumes, per_resume);
+    }
+
+    printf("(%d bytes per coroutine)\n", (int)sizeof(coroutine_t));
+}
+
+void init_coroutines()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = print_coroutines,
+        .name = "coroutines",
+        .name_len = 10,
+    };
+
+    add_command(cmd);
+}
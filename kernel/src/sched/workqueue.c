@@ -0,0 +1,164 @@
+#include <coroutine.h>
+#include <percpu.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <workqueue.h>
+
+typedef struct
+{
+    work_fn_t fn;
+    uint32_t arg;
+    void *data;
+} work_t;
+
+/// A slot's sequence tells who may use it next: when it's equal to the
+/// enqueue position, the slot is free for the producer that claims that
+/// position; when it's equal to the position + 1, the work in it was fully
+/// written and may be consumed.
+typedef struct
+{
+    volatile uint32_t sequence;
+    work_t work;
+} work_slot_t;
+
+/// A bounded multi-producer single-consumer queue. Producers are the interrupt
+/// handlers and the tasks of one CPU, the consumer is that CPU's worker.
+typedef struct
+{
+    work_slot_t slots[WORKQUEUE_SIZE];
+    volatile uint32_t enqueue_pos;
+    uint32_t dequeue_pos;
+
+    /// @brief Signalled for every queued work item
+    co_event_t event;
+    coroutine_t worker;
+    /// @brief Work items executed since the worker last yielded
+    uint32_t batch;
+
+    uint32_t executed;
+    volatile uint32_t overflows;
+} workqueue_t;
+
+static DEFINE_PER_CPU(workqueue_t, workqueues);
+
+/// @brief The maximum amount of work items executed before the worker lets
+///        other coroutines run
+#define WORKER_BATCH 16
+
+bool work_queue(work_fn_t fn, uint32_t arg, void *data)
+{
+    workqueue_t *queue = &this_cpu(workqueues);
+    uint32_t pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+    work_slot_t *slot;
+
+    while (true)
+    {
+        slot = &queue->slots[pos & (WORKQUEUE_SIZE - 1)];
+        uint32_t sequence =
+            __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(sequence - pos);
+
+        if (diff == 0)
+        {
+            // the slot is free, try to claim it. On failure `pos` is reloaded
+            // with the position claimed by whoever was faster
+            if (__atomic_compare_exchange_n(&queue->enqueue_pos, &pos, pos + 1,
+                                            true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // the consumer did not free this slot yet - the queue is full
+            __atomic_add_fetch(&queue->overflows, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        else
+        {
+            pos = __atomic_load_n(&queue->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->work.fn = fn;
+    slot->work.arg = arg;
+    slot->work.data = data;
+
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    co_event_signal(&queue->event);
+
+    return true;
+}
+
+/// @brief Takes the oldest fully written work item out of the queue
+static bool work_dequeue(workqueue_t *queue, work_t *work)
+{
+    uint32_t pos = queue->dequeue_pos;
+    work_slot_t *slot = &queue->slots[pos & (WORKQUEUE_SIZE - 1)];
+
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + 1)
+    {
+        return false;
+    }
+
+    *work = slot->work;
+    queue->dequeue_pos = pos + 1;
+
+    __atomic_store_n(&slot->sequence, pos + WORKQUEUE_SIZE, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static void worker_loop(coroutine_t *co)
+{
+    workqueue_t *queue = (workqueue_t *)co->data;
+
+    co_begin(co);
+
+    while (true)
+    {
+        // every queued work item signals the event exactly once
+        co_await_event(co, &queue->event);
+
+        work_t work;
+
+        if (work_dequeue(queue, &work))
+        {
+            work.fn(work.arg, work.data);
+            queue->executed++;
+        }
+
+        if (++queue->batch == WORKER_BATCH)
+        {
+            queue->batch = 0;
+            co_yield(co);
+        }
+    }
+
+    co_end(co);
+}
+
+void workqueue_get_stats(uint32_t *executed, uint32_t *overflows)
+{
+    workqueue_t *queue = &this_cpu(workqueues);
+
+    *executed = queue->executed;
+    *overflows = queue->overflows;
+}
+
+void setup_workqueue(void)
+{
+    for (unsigned int cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+        workqueue_t *queue = &per_cpu(workqueues, cpu);
+
+        for (uint32_t i = 0; i < WORKQUEUE_SIZE; i++)
+        {
+            queue->slots[i].sequence = i;
+        }
+
+        coroutine_spawn(&queue->worker, "worker", worker_loop, queue);
+    }
+}
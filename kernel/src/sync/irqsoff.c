@@ -0,0 +1,298 @@
+#include <input.h>
+#include <irqsoff.h>
+#include <ksym.h>
+#include <panic.h>
+#include <percpu.h>
+#include <random.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sync.h>
+#include <workqueue.h>
+
+#ifdef IRQSOFF_TRACE
+
+/// @brief The amount of longest sections kept per CPU
+#define IRQSOFF_TOP 8
+
+/// @brief The default threshold, a bit over the PIT's period on a ~2 GHz CPU.
+///        Anything longer delays a timer tick.
+#define IRQSOFF_DEFAULT_THRESHOLD 2500000
+
+typedef enum
+{
+    IRQSOFF_IGNORE,
+    IRQSOFF_LOG,
+    IRQSOFF_PANIC,
+} irqsoff_action_t;
+
+/// The longest section seen from one place in the code
+typedef struct
+{
+    /// @brief The address of the code that disabled interrupts, or `0` for
+    ///        interrupt handlers
+    uintptr_t caller;
+    /// @brief The vector of the interrupt handler, or `-1`
+    int32_t vector;
+    uint32_t count;
+    uint32_t max_cycles;
+} irqsoff_entry_t;
+
+typedef struct
+{
+    /// @brief When interrupts were disabled, or `0` if they're enabled
+    uint64_t off_since;
+    uintptr_t off_caller;
+
+    /// @brief Sorted from the longest section
+    irqsoff_entry_t top[IRQSOFF_TOP];
+    uint32_t sections;
+
+    /// @brief The section that exceeded the threshold, until it's logged
+    irqsoff_entry_t report;
+    bool report_pending;
+} irqsoff_t;
+
+/// Only updated with interrupts disabled, by the CPU the instance belongs to
+static DEFINE_PER_CPU(irqsoff_t, irqsoff);
+
+static uint32_t threshold_cycles = IRQSOFF_DEFAULT_THRESHOLD;
+static irqsoff_action_t threshold_action = IRQSOFF_LOG;
+
+static void print_section_owner(const irqsoff_entry_t *entry)
+{
+    if (entry->vector >= 0)
+    {
+        printf("interrupt %d", entry->vector);
+    }
+    else
+    {
+        ksym_print(entry->caller);
+    }
+}
+
+static void report_irqsoff_section(uint32_t cpu, void *data)
+{
+    (void)data;
+
+    irqsoff_t *state = &per_cpu(irqsoff, cpu);
+
+    printf("interrupts were off for %u cycles at ", state->report.max_cycles);
+    print_section_owner(&state->report);
+    printf(" (threshold: %u)\n", threshold_cycles);
+
+    __atomic_store_n(&state->report_pending, false, __ATOMIC_RELEASE);
+}
+
+/// @brief Returns the entry of the section's owner, claiming the entry with
+///        the shortest section if it's not in the table yet. Returns `NULL`
+///        if every entry in the table is longer than `cycles`.
+static irqsoff_entry_t *irqsoff_find_entry(irqsoff_t *state, uintptr_t caller,
+                                           int32_t vector, uint32_t cycles)
+{
+    for (int i = 0; i < IRQSOFF_TOP; i++)
+    {
+        irqsoff_entry_t *entry = &state->top[i];
+
+        if (entry->count != 0 && entry->caller == caller &&
+            entry->vector == vector)
+        {
+            return entry;
+        }
+    }
+
+    irqsoff_entry_t *last = &state->top[IRQSOFF_TOP - 1];
+
+    if (last->count != 0 && last->max_cycles >= cycles)
+    {
+        return NULL;
+    }
+
+    last->caller = caller;
+    last->vector = vector;
+    last->count = 0;
+    last->max_cycles = 0;
+
+    return last;
+}
+
+static void irqsoff_record(uintptr_t caller, int32_t vector, uint32_t cycles)
+{
+    irqsoff_t *state = &this_cpu(irqsoff);
+
+    state->sections++;
+
+    irqsoff_entry_t *entry = irqsoff_find_entry(state, caller, vector, cycles);
+
+    if (!entry)
+    {
+        return;
+    }
+
+    entry->count++;
+
+    if (cycles <= entry->max_cycles)
+    {
+        return;
+    }
+
+    entry->max_cycles = cycles;
+
+    // keep the table sorted, the entry can only move up
+    while (entry > state->top && (entry - 1)->max_cycles < cycles)
+    {
+        irqsoff_entry_t tmp = *(entry - 1);
+        *(entry - 1) = *entry;
+        *entry = tmp;
+        entry--;
+    }
+
+    if (threshold_action == IRQSOFF_IGNORE || cycles <= threshold_cycles)
+    {
+        return;
+    }
+
+    if (threshold_action == IRQSOFF_PANIC)
+    {
+        start_kpanic();
+        printf("interrupts were off for %u cycles at ", cycles);
+        print_section_owner(entry);
+        printf("\nthreshold: %u cycles\n", threshold_cycles);
+        end_kpanic();
+    }
+
+    // only new worst cases of each caller are logged, one at a time, so this
+    // can't flood the terminal
+    if (!state->report_pending)
+    {
+        state->report = *entry;
+        state->report_pending = true;
+
+        if (!work_queue(report_irqsoff_section, cpu_id(), NULL))
+        {
+            state->report_pending = false;
+        }
+    }
+}
+
+void irqsoff_begin(uintptr_t caller)
+{
+    irqsoff_t *state = &this_cpu(irqsoff);
+
+    state->off_since = rdtsc();
+    state->off_caller = caller;
+}
+
+void irqsoff_end(void)
+{
+    irqsoff_t *state = &this_cpu(irqsoff);
+
+    // interrupts were disabled by code that isn't traced, e.g. at boot
+    if (state->off_since == 0)
+    {
+        return;
+    }
+
+    uint32_t cycles = (uint32_t)(rdtsc() - state->off_since);
+    state->off_since = 0;
+
+    irqsoff_record(state->off_caller, -1, cycles);
+}
+
+void irqsoff_record_interrupt(uint32_t vector, uint32_t eflags, uint64_t entry,
+                              uint64_t exit)
+{
+    // an interrupt in a section that already runs with interrupts disabled
+    // (i.e. an exception) is part of that section
+    if ((eflags & EFLAGS_IF) == 0)
+    {
+        return;
+    }
+
+    irqsoff_record(0, (int32_t)vector, (uint32_t)(exit - entry));
+}
+
+static void print_irqsoff(void)
+{
+    static const char *action_names[] = {"none", "log", "panic"};
+
+    irqsoff_t *state = &this_cpu(irqsoff);
+
+    printf("%u sections, threshold %u cycles (action: %s)\n", state->sections,
+           threshold_cycles, action_names[threshold_action]);
+    printf("max cycles  count  disabled by\n");
+
+    for (int i = 0; i < IRQSOFF_TOP; i++)
+    {
+        irqsoff_entry_t *entry = &state->top[i];
+
+        if (entry->count == 0)
+        {
+            break;
+        }
+
+        printf("%u  %u  ", entry->max_cycles, entry->count);
+        print_section_owner(entry);
+        printf("\n");
+    }
+}
+
+/// @brief `irqsoff [reset | threshold <cycles> | action none|log|panic]`
+void irqsoff_command(const char *args)
+{
+    if (strcmp(args, "reset") == 0)
+    {
+        irq_flags_t flags = irq_save();
+
+        irqsoff_t *state = &this_cpu(irqsoff);
+        memset(state->top, 0, sizeof(state->top));
+        state->sections = 0;
+
+        irq_restore(flags);
+    }
+    else if (memcmp(args, "threshold ", 10) == 0)
+    {
+        threshold_cycles = (uint32_t)atoi(args + 10);
+    }
+    else if (strcmp(args, "action none") == 0)
+    {
+        threshold_action = IRQSOFF_IGNORE;
+    }
+    else if (strcmp(args, "action log") == 0)
+    {
+        threshold_action = IRQSOFF_LOG;
+    }
+    else if (strcmp(args, "action panic") == 0)
+    {
+        threshold_action = IRQSOFF_PANIC;
+    }
+    else
+    {
+        print_irqsoff();
+    }
+}
+
+#else
+
+void irqsoff_command(const char *args)
+{
+    (void)args;
+
+    printf("irqsoff is disabled, build the kernel with -D IRQSOFF_TRACE\n");
+}
+
+#endif
+
+void init_irqsoff()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = irqsoff_command,
+        .name = "irqsoff",
+        .name_len = 7,
+    };
+
+    add_command(cmd);
+}
@@ -0,0 +1,256 @@
+#include <input.h>
+#include <random.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sync.h>
+
+#ifdef LOCKSTAT
+
+/// All the lock classes that had at least one acquisition
+static lock_class_t *lock_classes;
+
+static void lockstat_register(lock_class_t *class)
+{
+    irq_flags_t flags = irq_save();
+
+    if (!class->registered)
+    {
+        class->registered = true;
+        class->next = lock_classes;
+        lock_classes = class;
+    }
+
+    irq_restore(flags);
+}
+
+static void lockstat_acquired(lock_class_t *class, uint32_t spins,
+                              uint64_t *acquired_at)
+{
+    if (!class)
+    {
+        return;
+    }
+
+    if (!class->registered)
+    {
+        lockstat_register(class);
+    }
+
+    class->acquisitions++;
+
+    if (spins != 0)
+    {
+        class->contentions++;
+        class->spins += spins;
+    }
+
+    *acquired_at = rdtsc();
+}
+
+static void lockstat_released(lock_class_t *class, uint64_t acquired_at)
+{
+    if (!class)
+    {
+        return;
+    }
+
+    uint32_t held = (uint32_t)(rdtsc() - acquired_at);
+
+    if (held > class->max_hold_cycles)
+    {
+        class->max_hold_cycles = held;
+    }
+}
+
+#else
+
+static inline void lockstat_acquired(lock_class_t *class, uint32_t spins,
+                                     uint64_t *acquired_at)
+{
+    (void)class;
+    (void)spins;
+    (void)acquired_at;
+}
+
+static inline void lockstat_released(lock_class_t *class,
+                                     uint64_t acquired_at)
+{
+    (void)class;
+    (void)acquired_at;
+}
+
+#endif
+
+void spin_lock(spinlock_t *lock)
+{
+    uint16_t ticket =
+        __atomic_fetch_add(&lock->next_ticket, 1, __ATOMIC_RELAXED);
+    uint32_t spins = 0;
+
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket)
+    {
+        cpu_relax();
+        spins++;
+    }
+
+    lockstat_acquired(lock->class, spins, &lock->acquired_at);
+}
+
+bool spin_trylock(spinlock_t *lock)
+{
+    uint16_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+    uint16_t expected = owner;
+
+    // the lock is free only when nobody else holds or waits for a ticket
+    if (!__atomic_compare_exchange_n(&lock->next_ticket, &expected, owner + 1,
+                                     false, __ATOMIC_ACQUIRE,
+                                     __ATOMIC_RELAXED))
+    {
+        return false;
+    }
+
+    lockstat_acquired(lock->class, 0, &lock->acquired_at);
+
+    return true;
+}
+
+void spin_unlock(spinlock_t *lock)
+{
+    lockstat_released(lock->class, lock->acquired_at);
+
+    __atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+irq_flags_t spin_lock_irqsave(spinlock_t *lock)
+{
+    irq_flags_t flags =
+        irq_save_from((uintptr_t)__builtin_return_address(0));
+
+    spin_lock(lock);
+
+    return flags;
+}
+
+void spin_unlock_irqrestore(spinlock_t *lock, irq_flags_t flags)
+{
+    spin_unlock(lock);
+
+    irq_restore(flags);
+}
+
+void read_lock(rwlock_t *lock)
+{
+    uint32_t spins = 0;
+
+    while (true)
+    {
+        int32_t count = __atomic_load_n(&lock->count, __ATOMIC_RELAXED);
+
+        if (count >= 0 &&
+            __atomic_compare_exchange_n(&lock->count, &count, count + 1, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+
+        cpu_relax();
+        spins++;
+    }
+
+    // readers share the lock, so only the writers' hold time is tracked
+    uint64_t acquired_at;
+    lockstat_acquired(lock->class, spins, &acquired_at);
+}
+
+void read_unlock(rwlock_t *lock)
+{
+    __atomic_sub_fetch(&lock->count, 1, __ATOMIC_RELEASE);
+}
+
+void write_lock(rwlock_t *lock)
+{
+    uint32_t spins = 0;
+
+    while (true)
+    {
+        int32_t expected = 0;
+
+        if (__atomic_compare_exchange_n(&lock->count, &expected, -1, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+
+        cpu_relax();
+        spins++;
+    }
+
+    lockstat_acquired(lock->class, spins, &lock->acquired_at);
+}
+
+void write_unlock(rwlock_t *lock)
+{
+    lockstat_released(lock->class, lock->acquired_at);
+
+    __atomic_store_n(&lock->count, 0, __ATOMIC_RELEASE);
+}
+
+void write_seqlock(seqlock_t *lock)
+{
+    spin_lock(&lock->writer);
+
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void write_sequnlock(seqlock_t *lock)
+{
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELEASE);
+
+    spin_unlock(&lock->writer);
+}
+
+bool read_seqretry(seqlock_t *lock, uint32_t start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    bool retry = __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != start;
+
+#ifdef LOCKSTAT
+    // a reader that has to retry was slowed down by a writer, which is the
+    // seqlock's equivalent of contention
+    if (retry && lock->writer.class)
+    {
+        lock->writer.class->contentions++;
+    }
+#endif
+
+    return retry;
+}
+
+void print_lockstat()
+{
+#ifdef LOCKSTAT
+    printf("class  acquisitions  contended  spins  max hold\n");
+
+    for (lock_class_t *class = lock_classes; class; class = class->next)
+    {
+        printf("%s  %d  %d  %d  %d\n", class->name, class->acquisitions,
+               class->contentions, class->spins, class->max_hold_cycles);
+    }
+#else
+    printf("lockstat is disabled, build the kernel with -D LOCKSTAT\n");
+#endif
+}
+
+void init_lockstat()
+{
+    scratchpad_cmd_t cmd = {
+        .callback = print_lockstat,
+        .name = "lockstat",
+        .name_len = 8,
+    };
+
+    add_command(cmd);
+}
@@ -1,7 +1,14 @@
+#include <bench.h>
+#include <game.h>
 #include <input.h>
+#include <metrics.h>
 #include <random.h>
+#include <replay.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <timer.h>
+#include <trace.h>
 #include <tty.h>
 
 tty_t tetris_tty;
@@ -9,6 +16,17 @@ tty_t tetris_tty;
 #define TETRIS_WIDTH 10
 #define TETRIS_HEIGHT 20
 
+/// The board is a bitboard with a 16-bit word per row. Column `x` is the bit
+/// `x + TETRIS_WALL`, the bits on both sides of the columns are always set and
+/// act as walls, so a single AND tells whether a piece fits into a row.
+#define TETRIS_WALL 3
+#define TETRIS_COLUMNS (((1u << TETRIS_WIDTH) - 1) << TETRIS_WALL)
+#define TETRIS_ROW_EMPTY ((uint16_t)~TETRIS_COLUMNS)
+#define TETRIS_ROW_FULL ((uint16_t)0xFFFF)
+
+/// @brief The size of the boxes holding the piece masks
+#define PIECE_BOX 4
+
 typedef struct
 {
     int32_t x;
@@ -21,9 +39,20 @@ typedef struct
     vec2_t offsets[4];
 } piece_shape_t;
 
+/// @brief A piece shape at one of its angles, see `build_piece_masks`
 typedef struct
 {
-    piece_shape_t *shape;
+    /// @brief The rows of the piece's box, bit 0 is the box's left column
+    uint16_t rows[PIECE_BOX];
+    /// @brief The box's top left corner relative to the piece's position
+    vec2_t corner;
+    /// @brief The blocks relative to the piece's position
+    vec2_t blocks[4];
+} piece_mask_t;
+
+typedef struct
+{
+    uint32_t shape;
     vec2_t position;
     uint32_t color;
     uint32_t angle;
@@ -31,14 +60,18 @@ typedef struct
 
 typedef struct
 {
-    int board[TETRIS_WIDTH * TETRIS_HEIGHT];
+    uint16_t rows[TETRIS_HEIGHT];
+    /// @brief The colors of the solidified blocks, only used for drawing
+    uint8_t colors[TETRIS_HEIGHT][TETRIS_WIDTH];
     piece_t falling_piece;
 } board_t;
 
 typedef struct
 {
     board_t board;
-    bool should_stop;
+    uint32_t steps_until_drop;
+    /// @brief The steps left until the game ends, `0` while it's played
+    uint32_t lost_steps;
 } tetris_game_t;
 
 #define SHAPE_COUNT 6
@@ -92,9 +125,9 @@ static piece_shape_t shapes[] = {
     },
 };
 
-#define COLOR_COUNT 6
+static piece_mask_t piece_masks[SHAPE_COUNT][4];
 
-typedef void (*piece_pos_callback_t)(vec2_t pos);
+#define COLOR_COUNT 6
 
 static int32_t colors[] = {
     TTY_COLOR_CYAN,  TTY_COLOR_BLUE,    TTY_COLOR_LIGHT_BROWN,
@@ -126,36 +159,80 @@ inline vec2_t negate_vec2(vec2_t vec)
     return (vec2_t){-vec.x, -vec.y};
 }
 
-int get_board_spot_unchecked(board_t *board, vec2_t pos)
+/// @brief Rotates every shape to every angle once, so that moving a piece
+///        never has to rotate its blocks again
+static void build_piece_masks(void)
 {
-    return board->board[pos.y * TETRIS_WIDTH + pos.x];
+    for (uint32_t shape = 0; shape < SHAPE_COUNT; shape++)
+    {
+        for (uint32_t angle = 0; angle < 4; angle++)
+        {
+            piece_mask_t *mask = &piece_masks[shape][angle];
+            vec2_t corner = {PIECE_BOX, PIECE_BOX};
+
+            for (int i = 0; i < 4; i++)
+            {
+                vec2_t rotated = rotate_vec2(shapes[shape].blocks[i], angle);
+                vec2_t block = add_vec2(rotated, shapes[shape].offsets[angle]);
+
+                mask->blocks[i] = block;
+                corner.x = block.x < corner.x ? block.x : corner.x;
+                corner.y = block.y < corner.y ? block.y : corner.y;
+            }
+
+            mask->corner = corner;
+            memset(mask->rows, 0, sizeof(mask->rows));
+
+            for (int i = 0; i < 4; i++)
+            {
+                vec2_t block = add_vec2(mask->blocks[i], negate_vec2(corner));
+
+                mask->rows[block.y] |= 1 << block.x;
+            }
+        }
+    }
 }
 
-bool is_board_spot_vacant(board_t *board, vec2_t pos)
+static inline const piece_mask_t *piece_mask(const piece_t *piece)
 {
-    if (pos.x < 0 || pos.x >= TETRIS_WIDTH || pos.y >= TETRIS_HEIGHT)
-    {
-        return false;
-    }
+    return &piece_masks[piece->shape][piece->angle % 4];
+}
 
-    return get_board_spot_unchecked(board, pos) == 0;
+static inline bool is_row_spot_taken(uint16_t row, int32_t x)
+{
+    return (row >> (x + TETRIS_WALL)) & 1;
 }
 
 /// @brief Returns whether the piece is either out of the bounds
 /// of the board, or collides with any elements on the board
 bool does_piece_colilde(board_t *board, piece_t *piece)
 {
-    piece_shape_t *shape = piece->shape;
-    uint32_t angle = piece->angle % 4;
+    const piece_mask_t *mask = piece_mask(piece);
+    int32_t shift = piece->position.x + mask->corner.x + TETRIS_WALL;
+    int32_t top = piece->position.y + mask->corner.y;
 
-    for (int i = 0; i < 4; i++)
+    // the left column of a box that doesn't fit into a row is always behind
+    // one of the walls
+    if (shift < 0 || shift > 16 - PIECE_BOX)
     {
-        vec2_t base_offset = shape->blocks[i];
-        vec2_t offset_rotated = rotate_vec2(base_offset, angle);
-        vec2_t offset = add_vec2(offset_rotated, shape->offsets[angle]);
-        vec2_t block_position = add_vec2(piece->position, offset);
+        return true;
+    }
+
+    for (int i = 0; i < PIECE_BOX; i++)
+    {
+        uint16_t row = mask->rows[i] << shift;
+
+        if (row == 0)
+        {
+            continue;
+        }
 
-        if (!is_board_spot_vacant(board, block_position))
+        if (top + i < 0 || top + i >= TETRIS_HEIGHT)
+        {
+            return true;
+        }
+
+        if (board->rows[top + i] & row)
         {
             return true;
         }
@@ -189,9 +266,9 @@ bool does_falling_piece_collide_after_rotating(board_t *board)
 }
 
 /// @brief Returns a random piece shape
-piece_shape_t *random_shape()
+uint32_t random_shape()
 {
-    return &shapes[rand() % SHAPE_COUNT];
+    return rand() % SHAPE_COUNT;
 }
 
 /// @brief Returns a random piece color
@@ -200,11 +277,22 @@ int32_t random_color()
     return colors[rand() % COLOR_COUNT];
 }
 
+/// @brief Empties the board
+void reset_board(board_t *board)
+{
+    memset(board, 0, sizeof(board_t));
+
+    for (int y = 0; y < TETRIS_HEIGHT; y++)
+    {
+        board->rows[y] = TETRIS_ROW_EMPTY;
+    }
+}
+
 /// @brief Spawns a new falling piece on the board
 /// @returns Whether the user lost the game
 bool spawn_falling_piece(board_t *board)
 {
-    piece_shape_t *shape = random_shape();
+    uint32_t shape = random_shape();
     int32_t color = random_color();
 
     piece_t piece = {shape, {5, 1}, color, 0};
@@ -216,235 +304,474 @@ bool spawn_falling_piece(board_t *board)
 
 void solidify_falling_piece(board_t *board)
 {
-    piece_shape_t *shape = board->falling_piece.shape;
-    uint32_t angle = board->falling_piece.angle % 4;
+    piece_t *piece = &board->falling_piece;
+    const piece_mask_t *mask = piece_mask(piece);
+    int32_t shift = piece->position.x + mask->corner.x + TETRIS_WALL;
+    int32_t top = piece->position.y + mask->corner.y;
+
+    for (int i = 0; i < PIECE_BOX; i++)
+    {
+        if (mask->rows[i] != 0)
+        {
+            board->rows[top + i] |= mask->rows[i] << shift;
+        }
+    }
 
     for (int i = 0; i < 4; i++)
     {
-        vec2_t base_offset = shape->blocks[i];
-        vec2_t offset_rotated = rotate_vec2(base_offset, angle);
-        vec2_t offset = add_vec2(offset_rotated, shape->offsets[angle]);
-        vec2_t block_position = add_vec2(board->falling_piece.position, offset);
+        vec2_t block_position = add_vec2(piece->position, mask->blocks[i]);
 
-        board->board[block_position.y * TETRIS_WIDTH + block_position.x] =
-            board->falling_piece.color;
+        board->colors[block_position.y][block_position.x] = piece->color;
     }
 }
 
-void draw_board(board_t *board)
+void draw_board(board_t *board, game_canvas_t *canvas)
 {
+    terminal_entry_color_t empty = {TTY_COLOR_DARK_GREY, TTY_COLOR_BLACK};
+
     // blitting the solidified elements
     for (int y = 0; y < TETRIS_HEIGHT; y++)
     {
         for (int x = 0; x < TETRIS_WIDTH; x++)
         {
-            int32_t spot = get_board_spot_unchecked(board, (vec2_t){x, y});
-
-            if (spot == 0)
+            if (!is_row_spot_taken(board->rows[y], x))
             {
-                terminal_entry_color_t entry = {TTY_COLOR_DARK_GREY,
-                                                TTY_COLOR_BLACK};
-                tty_set_color(&tetris_tty, entry);
-                tty_set_char_at(&tetris_tty, '.', x, y);
+                game_canvas_put(canvas, x, y, '.', empty);
             }
             else
             {
-                terminal_entry_color_t entry = {TTY_COLOR_WHITE, spot};
-                tty_set_color(&tetris_tty, entry);
-                tty_set_char_at(&tetris_tty, ' ', x, y);
+                terminal_entry_color_t entry = {TTY_COLOR_WHITE,
+                                                board->colors[y][x]};
+                game_canvas_put(canvas, x, y, ' ', entry);
             }
         }
     }
 
     // blitting the falling piece
     piece_t *falling_piece = &board->falling_piece;
-    piece_shape_t *falling_piece_shape = board->falling_piece.shape;
-    uint32_t angle = board->falling_piece.angle % 4;
+    const piece_mask_t *mask = piece_mask(falling_piece);
+    terminal_entry_color_t entry = {TTY_COLOR_WHITE, falling_piece->color};
 
     for (int i = 0; i < 4; i++)
     {
-        vec2_t base_offset = falling_piece_shape->blocks[i];
-        vec2_t offset_rotated = rotate_vec2(base_offset, angle);
-        vec2_t offset =
-            add_vec2(offset_rotated, falling_piece_shape->offsets[angle]);
-        vec2_t block_position = add_vec2(falling_piece->position, offset);
+        vec2_t block_position =
+            add_vec2(falling_piece->position, mask->blocks[i]);
 
-        terminal_entry_color_t entry = {TTY_COLOR_WHITE, falling_piece->color};
-        tty_set_color(&tetris_tty, entry);
-        tty_set_char_at(&tetris_tty, ' ', block_position.x, block_position.y);
+        game_canvas_put(canvas, block_position.x, block_position.y, ' ',
+                        entry);
     }
-
-    tty_flush(&tetris_tty);
 }
 
-void draw_lost_text()
+void draw_lost_text(game_canvas_t *canvas)
 {
-    tty_set_color(&tetris_tty,
-                  (terminal_entry_color_t){TTY_COLOR_WHITE, TTY_COLOR_RED});
-    tty_set_char_at(&tetris_tty, 'L', 3, 10);
-    tty_set_char_at(&tetris_tty, 'o', 4, 10);
-    tty_set_char_at(&tetris_tty, 's', 5, 10);
-    tty_set_char_at(&tetris_tty, 't', 6, 10);
-    tty_flush(&tetris_tty);
+    terminal_entry_color_t color = {TTY_COLOR_WHITE, TTY_COLOR_RED};
+
+    game_canvas_put(canvas, 3, 10, 'L', color);
+    game_canvas_put(canvas, 4, 10, 'o', color);
+    game_canvas_put(canvas, 5, 10, 's', color);
+    game_canvas_put(canvas, 6, 10, 't', color);
 }
 
-void check_board_for_clearing(board_t *board)
+/// @brief Removes the full rows and moves the rows above them down, in a
+///        single pass from the bottom. `colors` may be `NULL`.
+/// @returns The amount of removed rows
+static int compact_rows(uint16_t *rows, uint8_t (*colors)[TETRIS_WIDTH])
 {
+    int to = TETRIS_HEIGHT - 1;
 
-    for (int y = 0; y < TETRIS_HEIGHT; y++)
+    for (int from = TETRIS_HEIGHT - 1; from >= 0; from--)
     {
-        bool full = true;
-        for (int x = 0; x < TETRIS_WIDTH; x++)
+        if (rows[from] == TETRIS_ROW_FULL)
+        {
+            continue;
+        }
+
+        if (to != from)
         {
-            if (is_board_spot_vacant(board, (vec2_t){x, y}))
+            rows[to] = rows[from];
+
+            if (colors)
             {
-                full = false;
-                break;
+                memcpy(colors[to], colors[from], TETRIS_WIDTH);
             }
         }
-        if (!full)
-            continue;
 
-        size_t row_bytes = TETRIS_WIDTH * sizeof(int);
+        to--;
+    }
+
+    for (int y = to; y >= 0; y--)
+    {
+        rows[y] = TETRIS_ROW_EMPTY;
 
-        for (int y2 = y; y2 > 0; y2--)
+        if (colors)
         {
-            memmove(&board->board[TETRIS_WIDTH * y2],
-                    &board->board[TETRIS_WIDTH * (y2 - 1)], row_bytes);
+            memset(colors[y], 0, TETRIS_WIDTH);
         }
+    }
 
-        memset(&board->board[0], 0, row_bytes);
+    return to + 1;
+}
+
+/// @returns The amount of cleared lines
+int check_board_for_clearing(board_t *board)
+{
+    return compact_rows(board->rows, board->colors);
+}
+
+/// @brief The length of a step, the keyboard is read once a step
+#define TETRIS_STEP_US 20000
+
+/// @brief The steps between two drops of the falling piece
+#define TETRIS_DROP_STEPS 25
+
+/// @brief The steps for which the lost text is shown
+#define TETRIS_LOST_STEPS 100
 
-        y--;
+static tetris_game_t tetris_game;
+static game_runtime_t tetris_runtime;
+
+/// @brief The times the falling piece dropped
+DEFINE_COUNTER(tetris_steps);
+
+static void move_falling_piece(board_t *board, vec2_t offset)
+{
+    if (!does_falling_piece_collide_after_moving(board, offset))
+    {
+        board->falling_piece.position =
+            add_vec2(board->falling_piece.position, offset);
     }
 }
 
-void tetris_input_handler(keys_t key, bool was_pressed, void *data)
+static void tetris_handle_input(board_t *board, const game_input_t *input)
 {
-    if (!was_pressed)
+    if (game_key_pressed(input, KB_A) || game_key_pressed(input, KB_Arrow_Left))
     {
-        return;
+        move_falling_piece(board, (vec2_t){-1, 0});
+    }
+
+    if (game_key_pressed(input, KB_D) ||
+        game_key_pressed(input, KB_Arrow_Right))
+    {
+        move_falling_piece(board, (vec2_t){1, 0});
     }
 
-    tetris_game_t *game = (tetris_game_t *)data;
-    board_t *board = &game->board;
+    if (game_key_pressed(input, KB_S) || game_key_pressed(input, KB_Arrow_Down))
+    {
+        move_falling_piece(board, (vec2_t){0, 1});
+    }
 
-    switch (key)
+    if (game_key_pressed(input, KB_W) || game_key_pressed(input, KB_Arrow_Up))
     {
-    case KB_A:
-    case KB_Arrow_Left:
-        if (!does_falling_piece_collide_after_moving(board, (vec2_t){-1, 0}))
-        {
-            board->falling_piece.position =
-                add_vec2(board->falling_piece.position, (vec2_t){-1, 0});
-        }
-        break;
-    case KB_D:
-    case KB_Arrow_Right:
-        if (!does_falling_piece_collide_after_moving(board, (vec2_t){1, 0}))
-        {
-            board->falling_piece.position =
-                add_vec2(board->falling_piece.position, (vec2_t){1, 0});
-        }
-        break;
-    case KB_S:
-    case KB_Arrow_Down:
-        if (!does_falling_piece_collide_after_moving(board, (vec2_t){0, 1}))
-        {
-            board->falling_piece.position =
-                add_vec2(board->falling_piece.position, (vec2_t){0, 1});
-        }
-        break;
-    case KB_W:
-    case KB_Arrow_Up:
         if (!does_falling_piece_collide_after_rotating(board))
         {
             board->falling_piece.angle++;
         }
-        break;
-    case KB_Q:
-    case KB_Esc:
-        game->should_stop = true;
-        return;
-    default:
-        return;
+    }
+}
+
+/// @brief Drops the falling piece, or solidifies it and spawns the next one
+/// @returns Whether the user lost the game
+static bool drop_falling_piece(board_t *board)
+{
+    TRACE(tetris_step, 0);
+    counter_inc(tetris_steps);
+
+    if (!does_falling_piece_collide_after_moving(board, (vec2_t){0, 1}))
+    {
+        board->falling_piece.position =
+            add_vec2(board->falling_piece.position, (vec2_t){0, 1});
+        return false;
     }
 
-    draw_board(board);
+    solidify_falling_piece(board);
+    check_board_for_clearing(board);
+
+    return spawn_falling_piece(board);
 }
 
-#define CYCLES 1000000000
+static bool tetris_update(void *state, const game_input_t *input)
+{
+    tetris_game_t *game = (tetris_game_t *)state;
 
-void run_tetris()
+    if (game_key_pressed(input, KB_Q) || game_key_pressed(input, KB_Esc))
+    {
+        return false;
+    }
+
+    if (game->lost_steps)
+    {
+        return --game->lost_steps > 0;
+    }
+
+    tetris_handle_input(&game->board, input);
+
+    if (--game->steps_until_drop > 0)
+    {
+        return true;
+    }
+
+    game->steps_until_drop = TETRIS_DROP_STEPS;
+
+    if (drop_falling_piece(&game->board))
+    {
+        game->lost_steps = TETRIS_LOST_STEPS;
+    }
+
+    return true;
+}
+
+static void tetris_render(void *state, game_canvas_t *canvas)
 {
-    tetris_game_t game;
-    memset(&game, 0, sizeof(tetris_game_t));
+    tetris_game_t *game = (tetris_game_t *)state;
 
-    // the pointer to the game will not be used after this function quits
-    // because we set the active tty back to the kernel tty
-    tty_set_keypress_callback(&tetris_tty, tetris_input_handler, &game);
-    tetris_tty.cursor_visible = false;
+    // the board isn't drawn again once the game is lost, the piece that
+    // didn't fit would cover the blocks it collided with
+    if (game->lost_steps)
+    {
+        draw_lost_text(canvas);
+        return;
+    }
+
+    draw_board(&game->board, canvas);
+}
+
+static const game_t tetris = {
+    .name = "tetris",
+    .step_us = TETRIS_STEP_US,
+    .update = tetris_update,
+    .render = tetris_render,
+};
 
-    tty_initialize(&tetris_tty);
-    set_active_tty(&tetris_tty);
+/// The headless simulation plays without drawing anything: every piece is
+/// placed where a greedy policy scores the board the highest, trying every
+/// angle and column and dropping the piece straight down from where it spawned.
 
-    srand((uint32_t)rdtsc());
+/// @brief The amount of pieces `tetris sim` places by default
+#define TETRIS_SIM_PIECES 10000
 
-    spawn_falling_piece(&game.board);
+/// @brief The seed of the simulation, so that its runs are comparable
+#define TETRIS_SIM_SEED 0x7E7215
 
-    uint64_t last_frame_time = rdtsc();
+static board_t tetris_sim_board;
 
-    while (!game.should_stop)
+static inline int count_bits(uint32_t bits)
+{
+    int count = 0;
+
+    for (; bits; bits &= bits - 1)
     {
-        uint64_t time = rdtsc();
+        count++;
+    }
 
-        if (time - last_frame_time < CYCLES)
+    return count;
+}
+
+/// @brief Scores the board with the usual weights for the cleared lines, the
+///        sum of the column heights, the holes and the bumpiness, x100
+static int32_t score_rows(const uint16_t *rows, int lines)
+{
+    int32_t heights[TETRIS_WIDTH] = {0};
+    uint32_t covered = 0;
+    int32_t holes = 0;
+
+    for (int y = 0; y < TETRIS_HEIGHT; y++)
+    {
+        uint32_t row = rows[y] & TETRIS_COLUMNS;
+        uint32_t tops = row & ~covered;
+
+        holes += count_bits(covered & ~row);
+        covered |= row;
+
+        for (; tops; tops &= tops - 1)
         {
-            continue;
+            heights[__builtin_ctz(tops) - TETRIS_WALL] = TETRIS_HEIGHT - y;
         }
+    }
+
+    int32_t height = heights[0];
+    int32_t bumpiness = 0;
+
+    for (int x = 1; x < TETRIS_WIDTH; x++)
+    {
+        int32_t step = heights[x] - heights[x - 1];
+
+        height += heights[x];
+        bumpiness += step < 0 ? -step : step;
+    }
+
+    return 76 * lines - 51 * height - 36 * holes - 18 * bumpiness;
+}
+
+/// @brief Moves the falling piece to where the greedy policy places it
+static void place_falling_piece_greedily(board_t *board)
+{
+    piece_t *piece = &board->falling_piece;
+    piece_t best = *piece;
+    int32_t best_score = INT32_MIN;
+    int32_t spawn_y = piece->position.y;
 
-        last_frame_time = time;
+    for (uint32_t angle = 0; angle < 4; angle++)
+    {
+        piece->angle = angle;
 
-        if (does_falling_piece_collide_after_moving(&game.board,
-                                                    (vec2_t){0, 1}))
+        for (int32_t x = -PIECE_BOX; x < TETRIS_WIDTH + PIECE_BOX; x++)
         {
-            solidify_falling_piece(&game.board);
-            check_board_for_clearing(&game.board);
-            bool did_loose = spawn_falling_piece(&game.board);
+            piece->position = (vec2_t){x, spawn_y};
 
-            if (did_loose)
+            if (does_piece_colilde(board, piece))
             {
-                draw_lost_text();
+                continue;
+            }
 
-                while (true)
-                {
-                    uint64_t time = rdtsc();
+            while (!does_falling_piece_collide_after_moving(board,
+                                                            (vec2_t){0, 1}))
+            {
+                piece->position.y++;
+            }
+
+            const piece_mask_t *mask = piece_mask(piece);
+            int32_t shift = x + mask->corner.x + TETRIS_WALL;
+            int32_t top = piece->position.y + mask->corner.y;
+            uint16_t rows[TETRIS_HEIGHT];
+
+            memcpy(rows, board->rows, sizeof(rows));
 
-                    if (time - last_frame_time > CYCLES * 2)
-                    {
-                        break;
-                    }
+            for (int i = 0; i < PIECE_BOX; i++)
+            {
+                if (mask->rows[i] != 0)
+                {
+                    rows[top + i] |= mask->rows[i] << shift;
                 }
+            }
 
-                break;
+            int lines = compact_rows(rows, NULL);
+            int32_t score = score_rows(rows, lines);
+
+            if (score > best_score)
+            {
+                best_score = score;
+                best = *piece;
             }
         }
-        else
+    }
+
+    // the piece fits where it spawned, so at least that column was scored
+    *piece = best;
+}
+
+typedef struct
+{
+    uint32_t placed;
+    uint32_t lines;
+    uint32_t games;
+} tetris_sim_t;
+
+/// @brief Places the next piece, and starts a new game if it didn't fit
+static void tetris_sim_step(tetris_sim_t *sim)
+{
+    board_t *board = &tetris_sim_board;
+
+    if (spawn_falling_piece(board))
+    {
+        sim->games++;
+        reset_board(board);
+        spawn_falling_piece(board);
+    }
+
+    place_falling_piece_greedily(board);
+    solidify_falling_piece(board);
+    sim->lines += check_board_for_clearing(board);
+    sim->placed++;
+}
+
+static void tetris_sim_reset(void)
+{
+    srand(TETRIS_SIM_SEED);
+    reset_board(&tetris_sim_board);
+}
+
+/// @brief `tetris sim [pieces]`
+static void tetris_sim_command(const char *args)
+{
+    uint32_t pieces = *args ? (uint32_t)atoi(args) : TETRIS_SIM_PIECES;
+    tetris_sim_t sim = {0, 0, 1};
+
+    tetris_sim_reset();
+
+    uint64_t start = rdtsc();
+
+    while (sim.placed < pieces)
+    {
+        tetris_sim_step(&sim);
+    }
+
+    uint64_t cycles = rdtsc() - start;
+    uint64_t placements = sim.placed;
+    uint64_t per_second =
+        cycles ? placements * timer_tsc_khz() * 1000 / cycles : 0;
+
+    printf("%u pieces, %u lines, %u games\n", sim.placed, sim.lines,
+           sim.games);
+    printf("%u cycles per placement, %u placements/s\n",
+           (uint32_t)(sim.placed ? cycles / sim.placed : 0),
+           (uint32_t)per_second);
+}
+
+static tetris_sim_t tetris_bench_sim;
+
+static void bench_tetris_place(void)
+{
+    tetris_sim_step(&tetris_bench_sim);
+}
+
+DEFINE_BENCH(tetris_place, .setup = tetris_sim_reset,
+             .run = bench_tetris_place);
+
+void run_tetris()
+{
+    if (game_is_running(&tetris_runtime))
+    {
+        return;
+    }
+
+    tetris_game_t *game = &tetris_game;
+    memset(game, 0, sizeof(tetris_game_t));
+    reset_board(&game->board);
+    game->steps_until_drop = TETRIS_DROP_STEPS;
+
+    srand(replay_seed());
+
+    spawn_falling_piece(&game->board);
+
+    game_start(&tetris_runtime, &tetris, game, &tetris_tty);
+}
+
+/// @brief `tetris [sim [pieces]]`
+void tetris_command(const char *args)
+{
+    if (memcmp(args, "sim", 3) == 0 && (args[3] == '\0' || args[3] == ' '))
+    {
+        args += 3;
+
+        while (*args == ' ')
         {
-            game.board.falling_piece.position =
-                add_vec2(game.board.falling_piece.position, (vec2_t){0, 1});
+            args++;
         }
 
-        draw_board(&game.board);
+        tetris_sim_command(args);
+    }
+    else
+    {
+        run_tetris();
     }
-
-    set_active_tty(&kernel_tty);
 }
 
 void init_tetris()
 {
+    build_piece_masks();
+
     scratchpad_cmd_t cmd = {
-        .callback = run_tetris,
+        .callback = tetris_command,
         .name = "tetris",
         .name_len = 6,
     };
@@ -8,6 +8,15 @@
 int printf(const char *__restrict fmt, ...);
 int vprintf(const char *__restrict fmt, va_list parameters);
 
+/// @brief Receives the output of `vcbprintf` one character at a time
+/// @returns `EOF` on failure
+typedef int (*printf_sink_t)(int c, void *ctx);
+
+/// @brief Like `vprintf`, but writes the output to `sink` instead of stdout
+/// @param ctx Passed to every `sink` call
+int vcbprintf(printf_sink_t sink, void *ctx, const char *__restrict fmt,
+              va_list parameters);
+
 int putchar(int);
 int puts(const char *);
 
@@ -4,4 +4,10 @@
 /// @brief Halts the execution of the program, never returning.
 __attribute__((__noreturn__)) void abort(void);
 
+/// @brief Parses the decimal integer at the beginning of the string, skipping
+///        leading spaces. Parsing stops at the first non-digit character.
+///
+/// @returns The parsed value, or `0` if the string doesn't start with a number
+int atoi(const char *str);
+
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define STRING_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /// @brief Compares the first `count` bytes of buffers `lhs` and `rhs`. The
 /// comparison is done left-to-right.
@@ -31,6 +32,16 @@ int memcmp(const void *lhs, const void *rhs, size_t count);
 /// @returns Returns back the `dest` pointer.
 void *memset(void *dest, int ch, size_t count);
 
+/// @brief Copies `value` into each of the first `count` 16-bit values of the
+///        `dest` buffer, e.g. to fill VGA text cells.
+///
+/// @param dest The destination pointer. Must be a valid non-null pointer,
+///             aligned to 2 bytes and valid for `count` 16-bit writes.
+/// @param value The value to store
+/// @param count The amount of values to store
+/// @returns Returns back the `dest` pointer.
+uint16_t *memset16(uint16_t *dest, uint16_t value, size_t count);
+
 /// @brief Moves `count` bytes from `src` to `dest`.
 ///
 /// Unlike `memmove`, the buffers may NOT overlap.
@@ -64,4 +75,12 @@ void *memmove(void *dest, const void *src, size_t count);
 /// @returns The length of the string (the position of the null byte)
 size_t strlen(const char *data);
 
+/// @brief Compares two null-terminated strings lexicographically
+///
+/// @param lhs The left-hand-side of the comparison
+/// @param rhs The right-hand-side of the comparison
+/// @returns `0` if the strings are equal, a negative value if `lhs` sorts
+///          before `rhs` and a positive value otherwise.
+int strcmp(const char *lhs, const char *rhs);
+
 #endif
\ No newline at end of file
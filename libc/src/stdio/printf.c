@@ -1,23 +1,30 @@
 #include <limits.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
 #if defined(__is_libk)
+#include <metrics.h>
 #include <tty.h>
+
+DEFINE_COUNTER(printf_calls);
+DEFINE_COUNTER(printf_bytes);
 #endif
 
-static bool print(const char *data, size_t length)
+static bool print(printf_sink_t sink, void *ctx, const char *data,
+                  size_t length)
 {
     const unsigned char *bytes = (const unsigned char *)data;
     for (size_t i = 0; i < length; i++)
-        if (putchar(bytes[i]) == EOF)
+        if (sink(bytes[i], ctx) == EOF)
             return false;
     return true;
 }
 
-int vprintf(const char *__restrict format, va_list parameters)
+int vcbprintf(printf_sink_t sink, void *ctx, const char *__restrict format,
+              va_list parameters)
 {
 
     int written = 0;
@@ -38,7 +45,7 @@ int vprintf(const char *__restrict format, va_list parameters)
                 // TODO: Set errno to EOVERFLOW.
                 return -1;
             }
-            if (!print(format, amount))
+            if (!print(sink, ctx, format, amount))
                 return -1;
             format += amount;
             written += amount;
@@ -56,7 +63,7 @@ int vprintf(const char *__restrict format, va_list parameters)
                 // TODO: Set errno to EOVERFLOW.
                 return -1;
             }
-            if (!print(&c, sizeof(c)))
+            if (!print(sink, ctx, &c, sizeof(c)))
                 return -1;
             written++;
         }
@@ -70,12 +77,14 @@ int vprintf(const char *__restrict format, va_list parameters)
                 // TODO: Set errno to EOVERFLOW.
                 return -1;
             }
-            if (!print(str, len))
+            if (!print(sink, ctx, str, len))
                 return -1;
             written += len;
         }
-        else if (*format == 'd')
+        else if (*format == 'd' || *format == 'u' || *format == 'x')
         {
+            bool is_unsigned = *format != 'd';
+            unsigned int base = *format == 'x' ? 16 : 10;
             format++;
             int val = va_arg(parameters, int);
             // estimate length via buffer
@@ -85,12 +94,12 @@ int vprintf(const char *__restrict format, va_list parameters)
             bool neg = false;
             if (val == 0)
             {
-                if (!print("0", 1))
+                if (!print(sink, ctx, "0", 1))
                     return -1;
                 written++;
                 continue;
             }
-            if (val < 0)
+            if (val < 0 && !is_unsigned)
             {
                 neg = true;
             }
@@ -98,8 +107,8 @@ int vprintf(const char *__restrict format, va_list parameters)
                 neg ? (unsigned int)(-(val + 1)) + 1 : (unsigned int)val;
             do
             {
-                *--ptr = '0' + (u % 10);
-                u /= 10;
+                *--ptr = "0123456789abcdef"[u % base];
+                u /= base;
             } while (u > 0);
             if (neg)
                 *--ptr = '-';
@@ -107,7 +116,7 @@ int vprintf(const char *__restrict format, va_list parameters)
             size_t len = (buffer + sizeof(buffer)) - start;
             if (maxrem < len)
                 return -1;
-            if (!print(start, len))
+            if (!print(sink, ctx, start, len))
                 return -1;
             written += len;
         }
@@ -120,7 +129,7 @@ int vprintf(const char *__restrict format, va_list parameters)
                 // TODO: Set errno to EOVERFLOW.
                 return -1;
             }
-            if (!print(format, len))
+            if (!print(sink, ctx, format, len))
                 return -1;
             written += len;
             format += len;
@@ -130,6 +139,18 @@ int vprintf(const char *__restrict format, va_list parameters)
     return written;
 }
 
+static int putchar_sink(int c, void *ctx)
+{
+    (void)ctx;
+
+    return putchar(c);
+}
+
+int vprintf(const char *__restrict format, va_list parameters)
+{
+    return vcbprintf(putchar_sink, NULL, format, parameters);
+}
+
 int printf(const char *__restrict format, ...)
 {
     va_list parameters;
@@ -140,6 +161,8 @@ int printf(const char *__restrict format, ...)
     va_end(parameters);
 
 #if defined(__is_libk)
+    counter_inc(printf_calls);
+    counter_add(printf_bytes, written > 0 ? written : 0);
     tty_flush(&kernel_tty);
 #endif
 
@@ -0,0 +1,27 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+int atoi(const char *str)
+{
+    while (*str == ' ')
+    {
+        str++;
+    }
+
+    bool negative = *str == '-';
+
+    if (*str == '-' || *str == '+')
+    {
+        str++;
+    }
+
+    int value = 0;
+
+    while (*str >= '0' && *str <= '9')
+    {
+        value = value * 10 + (*str - '0');
+        str++;
+    }
+
+    return negative ? -value : value;
+}
@@ -11,7 +11,7 @@ int memcmp(const void *lhs, const void *rhs, size_t count)
         {
             return -1;
         }
-        else if (rhs_bytes[i] > lhs_bytes[i])
+        else if (lhs_bytes[i] > rhs_bytes[i])
         {
             return 1;
         }
@@ -0,0 +1,33 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// @brief Two of the values, which may alias them
+typedef uint32_t __attribute__((may_alias)) value_pair_t;
+
+uint16_t *memset16(uint16_t *dest, uint16_t value, size_t count)
+{
+    size_t i = 0;
+
+    // stores two values at a time once `dest` is aligned to them
+    if (count && ((uintptr_t)dest & 2))
+    {
+        dest[i++] = value;
+    }
+
+    value_pair_t *dest_pairs = (value_pair_t *)(dest + i);
+    const uint32_t pair = (uint32_t)value << 16 | value;
+    const size_t pairs = (count - i) / 2;
+
+    for (size_t j = 0; j < pairs; j++)
+    {
+        dest_pairs[j] = pair;
+    }
+
+    for (i += pairs * 2; i < count; i++)
+    {
+        dest[i] = value;
+    }
+
+    return dest;
+}
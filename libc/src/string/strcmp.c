@@ -0,0 +1,24 @@
+#include <string.h>
+
+int strcmp(const char *lhs, const char *rhs)
+{
+    const unsigned char *lhs_bytes = (const unsigned char *)lhs;
+    const unsigned char *rhs_bytes = (const unsigned char *)rhs;
+
+    while (*lhs_bytes && *lhs_bytes == *rhs_bytes)
+    {
+        lhs_bytes++;
+        rhs_bytes++;
+    }
+
+    if (*lhs_bytes < *rhs_bytes)
+    {
+        return -1;
+    }
+    else if (*lhs_bytes > *rhs_bytes)
+    {
+        return 1;
+    }
+
+    return 0;
+}
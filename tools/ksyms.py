@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Generates the kernel's embedded symbol table.
+
+Reads the output of `nm -n` from stdin and writes an assembly file defining
+the table that `ksym_lookup` searches (see kernel/include/ksym.h). With empty
+input, it writes an empty table, used by the first pass of the link.
+"""
+
+import sys
+
+# names longer than this are truncated, the name offsets are 16-bit
+MAX_NAME = 63
+
+
+def read_functions(lines):
+    """Returns (address, name) of the text symbols, one per address."""
+    functions = {}
+
+    for line in lines:
+        parts = line.split()
+
+        if len(parts) != 3 or parts[1] not in "tTwW":
+            continue
+
+        address, kind, name = int(parts[0], 16), parts[1], parts[2]
+
+        # local labels of the assembly files aren't functions
+        if name.startswith(".L"):
+            continue
+
+        # prefer global names when several symbols share the address
+        if address not in functions or kind in "TW":
+            functions[address] = name[:MAX_NAME]
+
+    return sorted(functions.items())
+
+
+def main():
+    functions = read_functions(sys.stdin)
+
+    names = bytearray()
+    name_offsets = {}
+
+    for _, name in functions:
+        if name not in name_offsets:
+            name_offsets[name] = len(names)
+            names += name.encode() + b"\0"
+
+    if len(names) > 0xFFFF:
+        sys.exit("error: the symbol names don't fit in 64 KiB")
+
+    out = sys.stdout
+    out.write("/* Generated by tools/ksyms.py, do not edit */\n")
+    out.write(".section .rodata\n")
+    out.write(".global ksym_count\n.global ksym_addresses\n")
+    out.write(".global ksym_name_offsets\n.global ksym_names\n\n")
+
+    out.write(".balign 4\nksym_count:\n    .long %d\n\n" % len(functions))
+
+    out.write("ksym_addresses:\n")
+    for address, _ in functions:
+        out.write("    .long 0x%x\n" % address)
+
+    out.write("\n.balign 2\nksym_name_offsets:\n")
+    for _, name in functions:
+        out.write("    .short %d\n" % name_offsets[name])
+
+    out.write("\nksym_names:\n")
+    for name in name_offsets:
+        out.write('    .asciz "%s"\n' % name)
+
+
+if __name__ == "__main__":
+    main()
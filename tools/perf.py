@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""Runs the kernel's benchmarks in headless QEMU and checks for regressions.
+
+The kernel boots with its serial line on QEMU's stdio and the isa-debug-exit
+device attached. Commands are sent over the serial line one at a time, each
+after the kernel's `# ready` line, and the CSV blocks they write are collected:
+
+    # bench begin            -> one result per benchmark, its median cycles
+    # boottime begin         -> `boot_total_us`, the microseconds until the
+                                scheduler took over
+
+Finally `exit 0` ends QEMU with the kernel's exit code. The results are
+compared with the baseline: a result more than its tolerance above the
+baseline fails the run.
+
+    tools/perf.py --baseline perf/baseline.csv
+    tools/perf.py --baseline perf/baseline.csv --update-baseline
+
+The baseline is a CSV file with the columns `name,value,tolerance`, where
+`tolerance` is in percent and may be left empty to use `--tolerance`.
+"""
+
+import argparse
+import csv
+import os
+import queue
+import subprocess
+import sys
+import threading
+import time
+
+DEFAULT_ISO = "target/myos.iso"
+DEFAULT_COMMANDS = ["bench all", "boottime csv"]
+READY = "# ready"
+QEMU_EXIT_DEVICE = "isa-debug-exit,iobase=0xf4,iosize=0x04"
+
+
+class Kernel:
+    """A kernel running in QEMU, driven over its serial line."""
+
+    def __init__(self, iso, qemu, extra_args):
+        self.process = subprocess.Popen(
+            [
+                qemu,
+                "-cdrom",
+                iso,
+                "-display",
+                "none",
+                "-serial",
+                "stdio",
+                "-monitor",
+                "none",
+                "-no-reboot",
+                "-device",
+                QEMU_EXIT_DEVICE,
+            ]
+            + extra_args,
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+        )
+        self.lines = queue.Queue()
+        self.log = []
+
+        threading.Thread(target=self._read, daemon=True).start()
+
+    def _read(self):
+        for raw in self.process.stdout:
+            line = raw.decode("ascii", errors="replace").rstrip("\r\n")
+            self.log.append(line)
+            self.lines.put(line)
+
+        self.lines.put(None)
+
+    def wait_ready(self, timeout):
+        """Returns the lines written until the next `# ready` line."""
+        deadline = time.monotonic() + timeout
+        output = []
+
+        while True:
+            remaining = deadline - time.monotonic()
+
+            try:
+                line = self.lines.get(timeout=max(remaining, 0))
+            except queue.Empty:
+                raise TimeoutError("no '%s' within %ds" % (READY, timeout))
+
+            if line is None:
+                raise EOFError("QEMU exited")
+
+            if line.endswith(READY):
+                return output
+
+            output.append(line)
+
+    def send(self, command):
+        self.process.stdin.write(command.encode("ascii") + b"\n")
+        self.process.stdin.flush()
+
+    def exit_status(self, timeout):
+        """Returns the code the kernel passed to isa-debug-exit, or None."""
+        try:
+            status = self.process.wait(timeout=timeout)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+            self.process.wait()
+            return None
+
+        # QEMU exits with `(code << 1) | 1`, any other status is its own
+        return status >> 1 if status & 1 else None
+
+    def kill(self):
+        if self.process.poll() is None:
+            self.process.kill()
+            self.process.wait()
+
+
+def csv_block(lines, name):
+    """Returns the rows of the `# <name> begin/end` block as dicts."""
+    try:
+        begin = lines.index("# %s begin" % name)
+        end = lines.index("# %s end" % name, begin)
+    except ValueError:
+        return []
+
+    return list(csv.DictReader(lines[begin + 1 : end]))
+
+
+def collect(output):
+    results = {}
+
+    for row in csv_block(output, "bench"):
+        results[row["name"]] = int(row["median"])
+
+    for row in csv_block(output, "boottime"):
+        if row["stage"] == "total":
+            results["boot_total_us"] = int(row["duration_us"])
+
+    return results
+
+
+def load_baseline(path):
+    baseline = {}
+
+    with open(path, newline="") as file:
+        for row in csv.DictReader(file):
+            tolerance = row.get("tolerance") or None
+            baseline[row["name"]] = (
+                int(row["value"]),
+                float(tolerance) if tolerance else None,
+            )
+
+    return baseline
+
+
+def save_baseline(path, results, baseline):
+    os.makedirs(os.path.dirname(path) or ".", exist_ok=True)
+
+    with open(path, "w", newline="") as file:
+        writer = csv.writer(file, lineterminator="\n")
+        writer.writerow(["name", "value", "tolerance"])
+
+        for name, value in sorted(results.items()):
+            # keep the tolerances that were tuned by hand
+            tolerance = baseline.get(name, (None, None))[1]
+            writer.writerow([name, value, "" if tolerance is None else tolerance])
+
+
+def compare(results, baseline, default_tolerance):
+    """Prints the comparison and returns the names of the regressions."""
+    regressions = []
+
+    for name, value in sorted(results.items()):
+        if name not in baseline:
+            print("  %-24s %10d  (new)" % (name, value))
+            continue
+
+        base, tolerance = baseline[name]
+        tolerance = default_tolerance if tolerance is None else tolerance
+        change = (value - base) * 100.0 / base if base else 0.0
+        regressed = value > base * (1 + tolerance / 100.0)
+
+        print(
+            "  %-24s %10d  %+7.1f%% vs %d (tolerance %g%%)%s"
+            % (name, value, change, base, tolerance, "  REGRESSED" if regressed else "")
+        )
+
+        if regressed:
+            regressions.append(name)
+
+    for name in sorted(set(baseline) - set(results)):
+        print("  %-24s   missing from this run" % name)
+        regressions.append(name)
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--iso", default=DEFAULT_ISO, help="default: %(default)s")
+    parser.add_argument("--qemu", default="qemu-system-i386")
+    parser.add_argument(
+        "--qemu-arg", action="append", default=[], help="an extra QEMU argument"
+    )
+    parser.add_argument("--baseline", help="the baseline CSV file")
+    parser.add_argument(
+        "--update-baseline",
+        action="store_true",
+        help="write the results to the baseline instead of comparing",
+    )
+    parser.add_argument(
+        "--tolerance",
+        type=float,
+        default=10.0,
+        help="allowed slowdown in percent (default: %(default)s)",
+    )
+    parser.add_argument(
+        "--command",
+        action="append",
+        help="a command to run, repeatable (default: %s)" % DEFAULT_COMMANDS,
+    )
+    parser.add_argument("--timeout", type=int, default=120, help="per command")
+    parser.add_argument("--log", help="save the serial output to this file")
+    args = parser.parse_args()
+
+    kernel = Kernel(args.iso, args.qemu, args.qemu_arg)
+    output = []
+    status = None
+
+    try:
+        kernel.wait_ready(args.timeout)
+
+        for command in args.command or DEFAULT_COMMANDS:
+            print("> %s" % command, file=sys.stderr)
+            kernel.send(command)
+            output += kernel.wait_ready(args.timeout)
+
+        kernel.send("exit 0")
+        status = kernel.exit_status(args.timeout)
+    except (TimeoutError, EOFError) as error:
+        print("error: %s" % error, file=sys.stderr)
+        status = kernel.exit_status(0)
+    finally:
+        kernel.kill()
+
+        if args.log:
+            with open(args.log, "w") as file:
+                file.write("\n".join(kernel.log) + "\n")
+
+    if status != 0:
+        print("error: the kernel exited with status %s" % status, file=sys.stderr)
+        sys.exit(1 if status is None else status)
+
+    results = collect(output)
+
+    if not results:
+        sys.exit("error: the kernel reported no results")
+
+    if not args.baseline:
+        for name, value in sorted(results.items()):
+            print("%s,%d" % (name, value))
+        return
+
+    baseline = load_baseline(args.baseline) if os.path.exists(args.baseline) else {}
+
+    if args.update_baseline:
+        save_baseline(args.baseline, results, baseline)
+        print("baseline written to %s" % args.baseline)
+        return
+
+    if not baseline:
+        sys.exit(
+            "error: no baseline at %s, create it with --update-baseline "
+            "(make perf_baseline)"
+            % args.baseline
+        )
+
+    regressions = compare(results, baseline, args.tolerance)
+
+    if regressions:
+        sys.exit(
+            "error: %d regression(s): %s" % (len(regressions), ", ".join(regressions))
+        )
+
+
+if __name__ == "__main__":
+    main()
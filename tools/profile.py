@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Turns a `profile dump` captured from the serial line into folded stacks.
+
+The serial capture (e.g. `kernel.log` written by `make run`) may contain
+regular terminal output around the binary dumps, only the dumps are read.
+Each output line is `outermost;...;innermost count`, which is what
+flamegraph.pl and speedscope expect:
+
+    tools/profile.py kernel.log > profile.folded
+    flamegraph.pl profile.folded > profile.svg
+"""
+
+import argparse
+import bisect
+import shutil
+import struct
+import subprocess
+import sys
+from collections import Counter
+
+DEFAULT_BINARY = "target/artifacts/myos.bin"
+MAGIC = b"PRF1"
+END = b"PEND"
+
+
+def find_nm():
+    for nm in ("i686-elf-nm", "nm"):
+        if shutil.which(nm):
+            return nm
+    sys.exit("error: neither i686-elf-nm nor nm was found")
+
+
+def load_symbols(binary):
+    """Returns the sorted function addresses and their names."""
+    output = subprocess.run(
+        [find_nm(), "-n", binary], check=True, capture_output=True, text=True
+    ).stdout
+
+    addresses, names = [], []
+
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] in "tTwW":
+            addresses.append(int(parts[0], 16))
+            names.append(parts[2])
+
+    return addresses, names
+
+
+def symbolize(address, addresses, names):
+    index = bisect.bisect_right(addresses, address) - 1
+    if index < 0:
+        return hex(address)
+    return names[index]
+
+
+def parse_dumps(data):
+    """Yields the stacks (innermost first) of every dump in the capture."""
+    pos = data.find(MAGIC)
+
+    while pos != -1:
+        try:
+            cpu, samples, dropped = struct.unpack_from("<III", data, pos + 4)
+        except struct.error:
+            print("warning: truncated dump header", file=sys.stderr)
+            return
+
+        pos += 16
+
+        for _ in range(samples):
+            if pos >= len(data):
+                print("warning: truncated dump", file=sys.stderr)
+                return
+
+            depth = data[pos]
+            stack = struct.unpack_from("<%dI" % depth, data, pos + 1)
+            pos += 1 + 4 * depth
+            yield stack
+
+        if data[pos : pos + 4] != END:
+            print("warning: dump of cpu %d is corrupted" % cpu, file=sys.stderr)
+
+        if dropped:
+            print("cpu %d dropped %d samples" % (cpu, dropped), file=sys.stderr)
+
+        pos = data.find(MAGIC, pos)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="the serial line capture")
+    parser.add_argument(
+        "--binary", default=DEFAULT_BINARY, help="the kernel (default: %(default)s)"
+    )
+    args = parser.parse_args()
+
+    addresses, names = load_symbols(args.binary)
+
+    with open(args.capture, "rb") as capture:
+        data = capture.read()
+
+    folded = Counter()
+
+    for stack in parse_dumps(data):
+        # return addresses point after the call, which may already be the
+        # next function if the call was the caller's last instruction
+        calls = stack[:1] + tuple(address - 1 for address in stack[1:])
+        frames = [symbolize(address, addresses, names) for address in calls]
+        folded[";".join(reversed(frames))] += 1
+
+    for stack, count in sorted(folded.items()):
+        print(stack, count)
+
+
+if __name__ == "__main__":
+    main()
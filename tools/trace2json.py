@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Turns a `trace dump` captured from the serial line into a Chrome trace.
+
+The serial capture (e.g. `kernel.log` written by `make run`) may contain
+regular terminal output around the binary dumps, only the dumps are read.
+The output opens in chrome://tracing, Perfetto or speedscope:
+
+    tools/trace2json.py kernel.log > trace.json
+
+`_entry`/`_exit` tracepoints become the begin and end of a span named without
+the suffix, the others become instant events.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"TRC1"
+END = b"TEND"
+RECORD = struct.Struct("<QIHH")
+
+TRACE_INSTANT, TRACE_BEGIN, TRACE_END = range(3)
+PHASES = {TRACE_INSTANT: "i", TRACE_BEGIN: "B", TRACE_END: "E"}
+
+
+def span_name(name, kind):
+    for suffix in ("_entry", "_exit"):
+        if kind != TRACE_INSTANT and name.endswith(suffix):
+            return name[: -len(suffix)]
+    return name
+
+
+def parse_dumps(data):
+    """Yields the tracepoints, the TSC frequency and the records of every dump
+    in the capture."""
+    pos = data.find(MAGIC)
+
+    while pos != -1:
+        try:
+            cpu, tsc_khz, count = struct.unpack_from("<III", data, pos + 4)
+            pos += 16
+
+            tracepoints = []
+
+            for _ in range(count):
+                kind, length = data[pos], data[pos + 1]
+                name = data[pos + 2 : pos + 2 + length].decode("ascii")
+                tracepoints.append((name, kind))
+                pos += 2 + length
+
+            records, dropped = struct.unpack_from("<II", data, pos)
+            pos += 8
+        except (struct.error, IndexError):
+            print("warning: truncated dump header", file=sys.stderr)
+            return
+
+        if pos + records * RECORD.size > len(data):
+            print("warning: truncated dump", file=sys.stderr)
+            return
+
+        yield cpu, tsc_khz, tracepoints, [
+            RECORD.unpack_from(data, pos + i * RECORD.size) for i in range(records)
+        ]
+
+        pos += records * RECORD.size
+
+        if data[pos : pos + 4] != END:
+            print("warning: dump of cpu %d is corrupted" % cpu, file=sys.stderr)
+
+        if dropped:
+            print("cpu %d dropped %d records" % (cpu, dropped), file=sys.stderr)
+
+        pos = data.find(MAGIC, pos)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="the serial line capture")
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as capture:
+        data = capture.read()
+
+    events = []
+    start = None
+
+    for cpu, tsc_khz, tracepoints, records in parse_dumps(data):
+        if tsc_khz == 0:
+            sys.exit("error: the dump of cpu %d has no TSC frequency" % cpu)
+
+        for timestamp, arg, id, record_cpu in records:
+            if id >= len(tracepoints):
+                print("warning: unknown tracepoint %d" % id, file=sys.stderr)
+                continue
+
+            name, kind = tracepoints[id]
+
+            if start is None:
+                start = timestamp
+
+            event = {
+                "name": span_name(name, kind),
+                "ph": PHASES.get(kind, "i"),
+                # the trace format counts in microseconds
+                "ts": (timestamp - start) * 1000 / tsc_khz,
+                "pid": 0,
+                "tid": record_cpu,
+                "args": {"arg": arg},
+            }
+
+            if kind == TRACE_INSTANT:
+                event["s"] = "t"
+
+            events.append(event)
+
+    json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, sys.stdout)
+    print()
+
+
+if __name__ == "__main__":
+    main()